@@ -20,6 +20,8 @@
 #include	"protos.h"
 
 extern int flag_verbose;
+extern work_budget budget;
+extern physics_params physics;
 
 /*
  * A few variables global to the entire program:
@@ -151,14 +153,14 @@ double roche_limit(double diameter)
 /*--------------------------------------------------------------------------*/
 double inner_effect_limit(double a, double e, double mass)
 {
-    return (a * (1.0 - e) * (1.0 - mass) / (1.0 + CLOUD_ECCENTRICITY));
+    return (a * (1.0 - e) * (1.0 - mass) / (1.0 + physics.cloud_eccentricity));
 }
 
 /*--------------------------------------------------------------------------*/
 /*--------------------------------------------------------------------------*/
 double outer_effect_limit(double a, double e, double mass)
 {
-    return (a * (1.0 + e) * (1.0 + mass) / (1.0 - CLOUD_ECCENTRICITY));
+    return (a * (1.0 + e) * (1.0 + mass) / (1.0 - physics.cloud_eccentricity));
 }
 
 /*--------------------------------------------------------------------------*/
@@ -223,18 +225,20 @@ dust_pointer prior_dust_band (dust_pointer dust_head, dust_pointer band)
 /*    crit_mass    Mass at which, for this orbit and star, a normal planet  */
 /*                 begins to sweep up gas as well as dust and become a      */
 /*                 gas giant.                                               */
-/*    dust_head    Pointer to the head of the dust band list                */
+/*    band_head    Pointer to the head of the dust band list.  Since bands  */
+/*                 may be freed or added in front of it, the global         */
+/*                 'dust_head' is kept up to date as the list changes.      */
 /*                                                                          */
 /*  LOCAL VARIABLES:                                                        */
 /*    r_inner      Innermost gravitational effect limit of the object       */
 /*    r_outer      Outermost gravitational effect limit of the object       */
 /*                                                                          */
 /*--------------------------------------------------------------------------*/
-double collect_dust(double mass, double a, double e, double crit_mass, dust_pointer dust_head)
+double collect_dust(double mass, double a, double e, double crit_mass, dust_pointer band_head)
 {
     double mass_density, temp1, temp2, bandwidth, width, volume,
             accumulated_mass;
-    dust_pointer band, newband, gasband, prev_band;
+    dust_pointer band, newband, gasband, prev_band, next_band;
 
     /*
      *  Find the effective mass and its range of effect ('r_inner'
@@ -252,7 +256,7 @@ double collect_dust(double mass, double a, double e, double crit_mass, dust_poin
      *  Start with the original mass of the object:
      */
     accumulated_mass = mass;
-    for (band = dust_head; (band != NULL); band = band->next_band) {
+    for (band = band_head; (band != NULL); band = band->next_band) {
         /*
          *  If there is no gas in this band OR if the band lies outside
          *  the range of effect completely OR if no dust is present and
@@ -274,8 +278,8 @@ double collect_dust(double mass, double a, double e, double crit_mass, dust_poin
             mass_density = dust_density;
         }
         else {
-            mass_density = K * dust_density /
-                (1.0 + sqrt(crit_mass / mass) * (K - 1.0));
+            mass_density = physics.k * dust_density /
+                (1.0 + sqrt(crit_mass / mass) * (physics.k - 1.0));
         }
         bandwidth = (r_outer - r_inner);
         temp1 = r_outer - band->outer_edge;
@@ -295,7 +299,8 @@ double collect_dust(double mass, double a, double e, double crit_mass, dust_poin
 	 *	and create new gas bands (if the dust is removed from a dust
 	 *	band, it becomes a gas band).
 	 */
-	for (band = dust_head; (band != NULL); band = band->next_band) {
+	for (band = dust_head; (band != NULL); band = next_band) {
+        next_band = band->next_band;
         if (band->gas_present == FALSE) {
             continue;
         }
@@ -513,7 +518,7 @@ double critical_limit(double orb_radius, double eccentricity, double stell_lumin
 
     perihelion_dist = (orb_radius - orb_radius * eccentricity);
     temp = perihelion_dist * sqrt(stell_luminosity_ratio);
-    return(B * power(temp,-0.75));
+    return(physics.b * power(temp,-0.75));
 }
 
 
@@ -534,8 +539,9 @@ double accrete_dust(double mass, double a, double e, double crit_mass)
     do {
         mass = new_mass;
         new_mass = collect_dust(new_mass, a, e, crit_mass, dust_head);
+        budget.sweeps++;
     }
-    while ((new_mass - mass) > (0.001 * mass));
+    while (((new_mass - mass) > (0.001 * mass)) && !over_budget());
 	/*
 	 *  Traverse the dust bands to check if there is any dust remaining.
 	 *  The global boolean 'dust_left' is used in 'dist_masses'.
@@ -727,6 +733,8 @@ void coalesce_planetesimals(double a, double e, double mass, double crit_mass,
         new_planet->a = a;
         new_planet->e = e;
         new_planet->first_moon = NULL;
+        new_planet->moons_built = FALSE;
+        new_planet->finished = FALSE;
         new_planet->next_planet = NULL;
         if ((mass >= crit_mass)) {
             new_planet->mass_type = GAS_GIANT;
@@ -742,35 +750,34 @@ void coalesce_planetesimals(double a, double e, double mass, double crit_mass,
 
 
 /*--------------------------------------------------------------------------*/
-/*  This function builds a linked list of planets by repeatedly injecting   */
-/*  protoplanets into the gas and dust cloud about a star.  The process     */
-/*  will end when all of the dust has been swept up by the planets.         */
-/*  'orbit_type' may be either PLANET (indicating that we're building a     */
-/*  series of planetary bodies about a star) or MOON (indicating we're      */
-/*  building moons around a planet).                                        */
+/*  Get ready to build a linked list of planets about a body.  'mass_type'  */
+/*  may be either PLANET (indicating that we're building a series of        */
+/*  planetary bodies about a star) or MOON (indicating we're building       */
+/*  moons around a planet).  The limits of the cloud are kept in 'acc' so   */
+/*  that protoplanets can then be injected one at a time.                   */
 /*--------------------------------------------------------------------------*/
-planet_pointer dist_masses(double mass_ratio, double stell_luminosity_ratio,
+void start_accretion(accretion *acc, double mass_ratio, double stell_luminosity_ratio,
                int mass_type, planet_pointer planet_list, double radius)
 {
-    double a, e, mass, crit_mass, eff_inner_bound, eff_outer_bound,
-      planet_inner_bound, planet_outer_bound,
-	  dust_inner_bound, dust_outer_bound,
-      bound1, bound2, temp1;
-	dust_pointer band;
+    double dust_inner_bound, dust_outer_bound, temp1;
 
+    acc->mass_ratio = mass_ratio;
+    acc->stell_luminosity_ratio = stell_luminosity_ratio;
+    acc->mass_type = mass_type;
+    acc->injections = 0;
 	/*
 	 *	Figure out the inner and outer limits at which a body can exist
 	 *	about this body ('planet_inner_bound' and 'planet_outer_bound'):
 	 */
     if (mass_type == MOON) {
         planet_head = NULL;
-        planet_inner_bound = roche_limit(radius * 2.0);
+        acc->planet_inner_bound = roche_limit(radius * 2.0);
     }
     else {
         planet_head = planet_list;
-        planet_inner_bound = nearest_body(mass_ratio);
+        acc->planet_inner_bound = nearest_body(mass_ratio);
     }
-    planet_outer_bound = farthest_body(mass_ratio);
+    acc->planet_outer_bound = farthest_body(mass_ratio);
 
 	/*
 	 *	Figure out the innermost and outermost extent of the dust/gas
@@ -779,19 +786,19 @@ planet_pointer dist_masses(double mass_ratio, double stell_luminosity_ratio,
 	 *	eccentricity at the minimum distance from the primary:
 	 */
 	if (mass_type == PLANET) {
-		dust_inner_bound = inner_effect_limit(planet_inner_bound,
-			0.0, PROTOPLANET_MASS);
+		dust_inner_bound = inner_effect_limit(acc->planet_inner_bound,
+			0.0, physics.protoplanet_mass);
 		dust_outer_bound = stell_dust_limit(mass_ratio, 0.0, STAR);
-		temp1 = outer_effect_limit(planet_outer_bound, 0.0, PROTOPLANET_MASS);
+		temp1 = outer_effect_limit(acc->planet_outer_bound, 0.0, physics.protoplanet_mass);
 		if (dust_outer_bound > temp1) {
 			dust_outer_bound = temp1;
 		}
 	}
 	else if (mass_type == MOON) {
-		dust_inner_bound = inner_effect_limit(planet_inner_bound,
-			0.0, PROTOPLANET_MASS);
+		dust_inner_bound = inner_effect_limit(acc->planet_inner_bound,
+			0.0, physics.protoplanet_mass);
 		dust_outer_bound = stell_dust_limit(mass_ratio, radius, PLANET);
-		temp1 = outer_effect_limit(planet_outer_bound, 0.0, PROTOPLANET_MASS);
+		temp1 = outer_effect_limit(acc->planet_outer_bound, 0.0, physics.protoplanet_mass);
 		if (dust_outer_bound > temp1) {
 			dust_outer_bound = temp1;
 		}
@@ -804,107 +811,160 @@ planet_pointer dist_masses(double mass_ratio, double stell_luminosity_ratio,
 	 *  Set up a clean dust/gas cloud in a single band about the object:
 	 */
     set_initial_conditions(dust_inner_bound, dust_outer_bound);
+}
 
+/*--------------------------------------------------------------------------*/
+/*  Inject a single proto-mass into the cloud set up by 'start_accretion'.  */
+/*  TRUE is returned while there is still dust left to accrete (and work    */
+/*  left in the system's budget).                                           */
+/*--------------------------------------------------------------------------*/
+int inject_protoplanet(accretion *acc)
+{
+    double a, e, mass, crit_mass, eff_inner_bound, eff_outer_bound,
+      bound1, bound2;
+	dust_pointer band;
+
+    /*
+     *  A system out of its budget of work just stops accreting:
+     */
+    if (over_budget())
+        return(FALSE);
+    acc->injections++;
+    budget.injections++;
+    e = random_eccentricity( );
+    mass = physics.protoplanet_mass;
+#ifdef NOTUSED
+    innermost_limit = inner_effect_limit(planet_inner_bound,
+                         e,
+                         mass);
+    outermost_limit = outer_effect_limit(planet_outer_bound,
+                         e,
+                         mass);
+    if (innermost_limit > inner_dust) {
+        bound1 = planet_inner_bound;
+    }
+    else {
+        bound1 = inner_dust;
+    }
+    if (outermost_limit < outer_dust) {
+        bound2 = planet_outer_bound;
+    }
+    else {
+        bound2 = outer_dust;
+    }
+    if ((bound2 - bound1) < 0.0) {
+        return(NULL);
+    }
+#endif
 	/*
-	 *	Inject proto-masses until all the dust about the central body
-	 *	has been accumulated:
+	 *	Find the first dust/gas band with dust still present:
 	 */
-    while (dust_left) {
-        e = random_eccentricity( );
-        mass = PROTOPLANET_MASS;
-#ifdef NOTUSED
-        innermost_limit = inner_effect_limit(planet_inner_bound,
-                             e,
-                             mass);
-        outermost_limit = outer_effect_limit(planet_outer_bound,
-                             e,
-                             mass);
-        if (innermost_limit > inner_dust) {
-            bound1 = planet_inner_bound;
-        }
-        else {
-            bound1 = inner_dust;
-        }
-        if (outermost_limit < outer_dust) {
-            bound2 = planet_outer_bound;
-        }
-        else {
-            bound2 = outer_dust;
-        }
-        if ((bound2 - bound1) < 0.0) {
-            return(NULL);
-        }
+	band = dust_head;
+	while ((band != NULL) && (band->dust_present == FALSE)) {
+		band = band->next_band;
+	}
+	if (band == NULL) {
+		printf("ERROR: dust band checking internal error\n");
+		exit(1);
+	}
+	/*
+	 *	Choose a location for the proto-mass that is somewhere
+	 *	within gravitational effect range of the first band.  As
+	 *	this is done for each band, the innermost band with dust
+	 *	still remaining will move further and further from the primary
+	 *	until all dust in the system has been accreted.
+	 */
+#ifdef NOTDEF
+    bound1 = inner_effect_limit(band->inner_edge, e, mass);
+    bound2 = outer_effect_limit(band->outer_edge, e, mass);
 #endif
+    bound1 = band->inner_edge;
+    bound2 = band->outer_edge;
+	if (bound1 < acc->planet_inner_bound) {
+		bound1 = acc->planet_inner_bound;
+	}
+	if (bound2 > acc->planet_outer_bound) {
+		bound2 = acc->planet_outer_bound;
+	}
+	if (acc->planet_inner_bound > acc->planet_outer_bound) {
+		printf("ERROR: orbit bounding internal error\n");
+		exit(1);
+	}
+    a = random_number(bound1, bound2);
+    eff_inner_bound = inner_effect_limit(a, e, mass);
+    eff_outer_bound = outer_effect_limit(a, e, mass);
+    if (dust_available(eff_inner_bound, eff_outer_bound)) {
+        if (flag_verbose >= LEVEL1) {
+            if (acc->mass_type == PLANET)
+                printf("  Injecting proto-planet (%4.2lg AU)\n", a);
+            else printf("  Injecting proto-moon (%4.2lg AU)\n", a);
+        }
+        dust_density = physics.dust_density_coeff * sqrt(acc->mass_ratio)
+            * exp(-physics.alpha * power(a,(1.0 / physics.n)));
 		/*
-		 *	Find the first dust/gas band with dust still present:
-		 */
-		band = dust_head;
-		while ((band != NULL) && (band->dust_present == FALSE)) {
-			band = band->next_band;
-		}
-		if (band == NULL) {
-			printf("ERROR: dust band checking internal error\n");
-			exit(1);
-		}
-		/*
-		 *	Choose a location for the proto-mass that is somewhere
-		 *	within gravitational effect range of the first band.  As
-		 *	this is done for each band, the innermost band with dust
-		 *	still remaining will move further and further from the primary
-		 *	until all dust in the system has been accreted.
+		 *	Assume that dust is ten times more dense around
+		 *	planets:
 		 */
-#ifdef NOTDEF
-        bound1 = inner_effect_limit(band->inner_edge, e, mass);
-        bound2 = outer_effect_limit(band->outer_edge, e, mass);
-#endif
-        bound1 = band->inner_edge;
-        bound2 = band->outer_edge;
-		if (bound1 < planet_inner_bound) {
-			bound1 = planet_inner_bound;
+		if (acc->mass_type == MOON) {
+			dust_density = dust_density * 10.0;
 		}
-		if (bound2 > planet_outer_bound) {
-			bound2 = planet_outer_bound;
-		}
-		if (planet_inner_bound > planet_outer_bound) {
-			printf("ERROR: orbit bounding internal error\n");
-			exit(1);
-		}
-        a = random_number(bound1, bound2);
-        eff_inner_bound = inner_effect_limit(a, e, mass);
-        eff_outer_bound = outer_effect_limit(a, e, mass);
-        if (dust_available(eff_inner_bound, eff_outer_bound)) {
-            if (flag_verbose >= LEVEL1) {
-                if (mass_type == PLANET)
-                    printf("  Injecting proto-planet (%4.2lg AU)\n", a);
-                else printf("  Injecting proto-moon (%4.2lg AU)\n", a);
-            }
-            dust_density = DUST_DENSITY_COEFF * sqrt(mass_ratio)
-                * exp(-ALPHA * power(a,(1.0 / N)));
-			/*
-			 *	Assume that dust is ten times more dense around
-			 *	planets:
-			 */
-			if (mass_type == MOON) {
-				dust_density = dust_density * 10.0;
-			}
-            crit_mass =critical_limit(a,e,stell_luminosity_ratio);
-            mass = accrete_dust(mass,a,e,crit_mass);
-            if ((mass != 0.0) && (mass != PROTOPLANET_MASS)) {
-                coalesce_planetesimals(a,e,mass,crit_mass,
-                               stell_luminosity_ratio,
-                               mass_type);
-            }
-            else if (flag_verbose >= LEVEL2) {
-                printf("    Neighbor too near (%lg AU).\n",a);
-            }
+        crit_mass =critical_limit(a,e,acc->stell_luminosity_ratio);
+        mass = accrete_dust(mass,a,e,crit_mass);
+        if ((mass != 0.0) && (mass != physics.protoplanet_mass)) {
+            coalesce_planetesimals(a,e,mass,crit_mass,
+                           acc->stell_luminosity_ratio,
+                           acc->mass_type);
         }
         else if (flag_verbose >= LEVEL2) {
-            printf("    Not enough dust at %lg AU.\n",a);
+            printf("    Neighbor too near (%lg AU).\n",a);
         }
     }
+    else if (flag_verbose >= LEVEL2) {
+        printf("    Not enough dust at %lg AU.\n",a);
+    }
+    return(dust_left);
+}
+
+/*--------------------------------------------------------------------------*/
+/*  All the dust is gone, so the (now empty) bands can be released and      */
+/*  the finished list of planets handed back.                               */
+/*--------------------------------------------------------------------------*/
+planet_pointer finish_accretion(void)
+{
+	dust_pointer band;
+
+	while (dust_head != NULL) {
+		band = dust_head;
+		dust_head = dust_head->next_band;
+		free(band);
+	}
     return(planet_head);
 }
 
+/*--------------------------------------------------------------------------*/
+/*  This function builds a linked list of planets by repeatedly injecting   */
+/*  protoplanets into the gas and dust cloud about a star.  The process     */
+/*  will end when all of the dust has been swept up by the planets.         */
+/*  'orbit_type' may be either PLANET (indicating that we're building a     */
+/*  series of planetary bodies about a star) or MOON (indicating we're      */
+/*  building moons around a planet).                                        */
+/*--------------------------------------------------------------------------*/
+planet_pointer dist_masses(double mass_ratio, double stell_luminosity_ratio,
+               int mass_type, planet_pointer planet_list, double radius)
+{
+    accretion acc;
+
+    start_accretion(&acc, mass_ratio, stell_luminosity_ratio, mass_type,
+                    planet_list, radius);
+	/*
+	 *	Inject proto-masses until all the dust about the central body
+	 *	has been accumulated:
+	 */
+    while (inject_protoplanet(&acc))
+        ;
+    return(finish_accretion());
+}
+
 /*--------------------------------------------------------------------------*/
 /*  This function checks if each planet is within the radius of the star    */
 /*  or if it is at least close enough to be vaporized.  If either of these  */
@@ -915,7 +975,7 @@ planet_pointer dist_masses(double mass_ratio, double stell_luminosity_ratio,
 /*--------------------------------------------------------------------------*/
 planet_pointer check_planets(planet_pointer head, double luminosity, double star_radius)
 {
-    planet_pointer planet, absorbed_planet, vaporized_planet;
+    planet_pointer planet, trailer, doomed_planet;
     double r_ecosphere, temperature;
 
     if (head == NULL)
@@ -925,34 +985,28 @@ planet_pointer check_planets(planet_pointer head, double luminosity, double star
      *  Start with the second planet on the list - the first one is
      *  always the primary star:
      */
+    trailer = head;
     planet = head->next_planet;
     while (planet != NULL) {
         temperature = eff_temp(r_ecosphere, planet->a, ROCKY_AIRLESS_ALBEDO);
-        if (planet->a <= star_radius) {
+        if ((planet->a <= star_radius) || (temperature >= 2000.0)) {
             /*
-             *  The planet is inside the primary!  Zap it:
+             *  The planet is inside the primary or too hot!  Zap it:
              */
-            absorbed_planet = planet;
+            if (flag_verbose >= LEVEL1) {
+                if (planet->a <= star_radius)
+                    printf("  Planet absorbed by primary!\n");
+                else printf("  Planet vaporized by primary!\n");
+            }
+            doomed_planet = planet;
             planet = planet->next_planet;
-            if (absorbed_planet == head)
-                head = planet;
-            free(absorbed_planet);
-            if (flag_verbose >= LEVEL1)
-                printf("  Planet absorbed by primary!\n");
+            trailer->next_planet = planet;
+            free(doomed_planet);
         }
-        else if (temperature >= 2000.0) {
-            /*
-             *  Too hot!  Zap it:
-             */
-            vaporized_planet = planet;
+        else {
+            trailer = planet;
             planet = planet->next_planet;
-            if (vaporized_planet == head)
-                head = planet;
-            free(vaporized_planet);
-            if (flag_verbose >= LEVEL1)
-                printf("  Planet vaporized by primary!\n");
         }
-        else planet = planet->next_planet;
     }
     return(head);
 }
@@ -981,6 +1035,9 @@ planet_pointer init_planet_list (star_pointer star_head)
         planet->a = star->orbit_radius;
         planet->mass = star->stell_mass_ratio;
         planet->e = random_eccentricity();
+        planet->first_moon = NULL;
+        planet->moons_built = FALSE;
+        planet->finished = FALSE;
         /*
          *  Insert the new planet in the planet list.  Keep the planet
          *  list sorted by distance from the primary:
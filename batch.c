@@ -0,0 +1,1084 @@
+/*----------------------------------------------------------------------*/
+/*                               batch.c                                */
+/*                                                                      */
+/*  Routines for generating many star systems in a single run (the -n   */
+/*  and -j flags).  On machines that can fork, the systems are built    */
+/*  by a number of worker processes.  Each worker formats its finished  */
+/*  systems into memory and hands them back through a pipe, so that     */
+/*  the parent process can do all of the writing in large blocks while  */
+/*  the workers carry on generating.                                    */
+/*                                                                      */
+/*  The systems of a batch either use consecutive seeds (-n), or are    */
+/*  listed in a manifest (-f), one system to a line:                    */
+/*                                                                      */
+/*      # seed  [flags]  [stars, just as with -t]                       */
+/*      42      -m       G2M/0 K1D/23                                   */
+/*      43                                                              */
+/*                                                                      */
+/*  The manifest is read a line at a time as the workers need more to   */
+/*  do, so it can be as long as you like (or a pipe).  Lines without    */
+/*  stars use the ones given with -t, or random ones.                   */
+/*                                                                      */
+/*  With a parameter sweep (-S, see params.c) the -n systems are made   */
+/*  again at each point of the sweep, so that a whole study can be      */
+/*  done in one run.                                                    */
+/*                                                                      */
+/*  A batch can also make snapshots of its systems rather than finish   */
+/*  them (-A), or finish the systems in a catalog of snapshots (-E);    */
+/*  see snapshot.c.                                                     */
+/*                                                                      */
+/*  A batch can be split between several runs (-H), each making one     */
+/*  shard of it, and the shards merged (-J); see shard.c.               */
+/*                                                                      */
+/*  With a search (-Q, see search.c) only the systems that meet its     */
+/*  conditions are written out.                                         */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <sys/types.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <errno.h>
+#include    <poll.h>
+#include    <signal.h>
+#include    <unistd.h>
+#include    <sys/wait.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern unsigned flag_seed;
+extern long flag_systems;
+extern int flag_workers;
+extern long flag_window;
+extern int flag_unordered;
+extern int flag_compress;
+extern int flag_moons;
+extern int flag_startype;
+extern star_pointer star_specs;
+extern char *flag_manifest;
+extern int flag_snapshot;
+extern FILE *catalog;
+extern int snapshot_loaded;
+extern physics_params physics;
+extern int sweep_type;
+extern long sweep_points;
+extern FILE *display_file;
+extern work_budget budget;
+extern int search_condition_count;
+extern int search_rejected;
+extern char *flag_census;
+extern long flag_top;
+extern long flag_sample;
+extern ranked_planet *ranking;
+extern long ranking_count;
+extern sample_stratum strata[];
+extern int stratum_count;
+extern int target_count;
+extern running_stat system_targets[];
+extern long converged_at;
+extern double system_weight;
+extern int system_weighted;
+extern int flag_shards;
+extern char *flag_journal;
+extern char *flag_quarantine;
+extern char *flag_timing;
+extern timing_histogram stage_histograms[];
+
+#ifdef MULTIPROC
+extern long resume_place;
+extern long resume_bytes;
+extern volatile sig_atomic_t stop_signal;
+#endif
+
+/*
+ *  How many systems of the batch have been finished, and how many of
+ *  those ran out of each work budget:
+ */
+long finished_systems = 0;
+long truncated_systems = 0;
+long short_of_injections = 0;
+long short_of_sweeps = 0;
+long short_of_time = 0;
+
+/*
+ *  The manifest, if the systems are listed in one:
+ */
+FILE *manifest = NULL;
+long manifest_line = 0;
+long manifest_errors = 0;
+
+/*
+ *  The parameters the current system is made with, if they aren't the
+ *  same for the whole batch:
+ */
+char system_tag[TASK_LINE_SIZE] = "";
+
+/*
+ *  The place of the current system in the batch:
+ */
+long system_index = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Pick the seed of the first system in the batch.  Every system after    */
+/*   it uses the next seed up, so any one of them can be regenerated on its */
+/*   own with '-s'.                                                         */
+/*--------------------------------------------------------------------------*/
+unsigned first_seed(void)
+{
+    double now;
+    long seconds;
+
+    if (flag_seed)
+        return(flag_seed);
+    now = wall_clock();
+    seconds = (long)now;
+    return((unsigned)((seconds % 100000L) + (long)((now - seconds) * 1000.0)));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Generate and describe the system for one seed (or finish the one read  */
+/*   back from a snapshot, whose random numbers are already under way).     */
+/*   In a search, systems that don't meet its conditions aren't described   */
+/*   at all, and in a census or a ranking they are only counted or ranked.  */
+/*   In a sample only the systems picked are described.                     */
+/*--------------------------------------------------------------------------*/
+void make_system(unsigned seed)
+{
+    double started;
+
+    start_system_timing();
+    search_rejected = REJECTED_NONE;
+    if (flag_snapshot) {
+        make_snapshot(seed);
+        end_system_timing();
+        return;
+    }
+    if (search_condition_count > 0)
+        search_rejected = search_system(seed);
+    else if (snapshot_loaded)
+        finish_snapshot();
+    else {
+        seed_random(seed);
+        generate_stellar_system();
+    }
+    if (target_count > 0)
+        measure_targets();
+    if (search_rejected == REJECTED_NONE) {
+        started = stage_clock();
+        if (flag_census != NULL)
+            census_system();
+        if (flag_top > 0)
+            rank_system(seed);
+        if (flag_sample > 0)
+            sample_system(seed);
+        if ((flag_census == NULL) && (flag_top == 0) && (flag_sample == 0))
+            write_system(seed);
+        stage_done(TIMING_DISPLAY, started);
+    }
+    free_system(&sys);
+    snapshot_loaded = FALSE;
+    end_system_timing();
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the description of the system in 'sys', headed by its seed,  */
+/*   any parameters it was made with and, if its primary was chosen by      */
+/*   weight, the weight it has in the population.                           */
+/*--------------------------------------------------------------------------*/
+void write_system(unsigned seed)
+{
+    fprintf(display_file, "Random number seed - %u\n", seed);
+    if (system_tag[0] != '\0')
+        fprintf(display_file, "Parameters - %s\n", system_tag);
+    if (system_weighted)
+        fprintf(display_file, "Weight - %.8g\n", system_weight);
+    display_system(&sys);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Count a finished system against the budgets it ran out of, and at the  */
+/*   end of the batch report how many were cut short.                       */
+/*--------------------------------------------------------------------------*/
+void note_truncation(int tripped)
+{
+    finished_systems++;
+    if (tripped == 0)
+        return;
+    truncated_systems++;
+    if (tripped & BUDGET_INJECTIONS)
+        short_of_injections++;
+    if (tripped & BUDGET_SWEEPS)
+        short_of_sweeps++;
+    if (tripped & BUDGET_TIME)
+        short_of_time++;
+}
+
+void report_truncation(void)
+{
+    if (truncated_systems == 0)
+        return;
+    fprintf(stderr, "%ld of %ld systems truncated (%ld out of injections, "
+                    "%ld out of sweeps, %ld out of time)\n",
+            truncated_systems, finished_systems, short_of_injections,
+            short_of_sweeps, short_of_time);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Open the manifest named with '-f' ("-" is standard input).             */
+/*--------------------------------------------------------------------------*/
+void open_manifest(void)
+{
+    if (flag_manifest == NULL)
+        return;
+    if ((*flag_manifest == '\0') || (strcmp(flag_manifest, "-") == 0))
+        manifest = stdin;
+    else if ((manifest = fopen(flag_manifest, "r")) == NULL) {
+        perror(flag_manifest);
+        exit(1);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Check one line of the manifest, and write it out again as the rest of  */
+/*   a task line ("seed moons stars").  FALSE is returned (after saying     */
+/*   why) if the line makes no sense.                                       */
+/*--------------------------------------------------------------------------*/
+int read_manifest_line(char *line, char *task)
+{
+    char *word;
+    char stars[TASK_LINE_SIZE];
+    star_pointer star;
+    unsigned seed;
+    int moons;
+
+    if (((word = strtok(line, " \t\r\n")) == NULL)
+        || (sscanf(word, "%u", &seed) != 1) || (seed == 0)) {
+        fprintf(stderr, "ERROR: manifest line %ld has no seed\n", manifest_line);
+        return(FALSE);
+    }
+    moons = flag_moons;
+    stars[0] = '\0';
+    while ((word = strtok(NULL, " \t\r\n")) != NULL) {
+        if (strcmp(word, "-m") == 0) {
+            moons = TRUE;
+        }
+        else if (word[0] == '-') {
+            fprintf(stderr, "ERROR: manifest line %ld has unknown flag <%s>\n",
+                    manifest_line, word);
+            return(FALSE);
+        }
+        else if ((star = read_startype(word)) == NULL) {
+            fprintf(stderr, "ERROR: manifest line %ld has bad star <%s>\n",
+                    manifest_line, word);
+            return(FALSE);
+        }
+        else {
+            free(star);
+            strcat(stars, " ");
+            strcat(stars, word);
+        }
+    }
+    sprintf(task, "%u %d%s", seed, moons, stars);
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Make up the task line for system 'index' of the batch: its index,      */
+/*   seed, whether it has moons, the parameters of its point in any sweep   */
+/*   and any stars it is to have.  When finishing a catalog the task is     */
+/*   instead the index and the word "snapshot", followed on the next lines  */
+/*   by the snapshot itself.  FALSE is returned once there are no more      */
+/*   systems.  Bad manifest lines are reported and skipped.                 */
+/*--------------------------------------------------------------------------*/
+int next_task_line(long index, unsigned seed, char *task)
+{
+    char line[TASK_LINE_SIZE];
+    char rest[TASK_LINE_SIZE];
+
+    if (catalog != NULL) {
+        sprintf(task, "%ld snapshot\n", index);
+        return(read_snapshot_text(catalog, task + strlen(task),
+                                  SNAPSHOT_SIZE - (long)strlen(task)));
+    }
+    if (manifest == NULL) {
+        if (index >= flag_systems * sweep_points)
+            return(FALSE);
+        sprintf(task, "%ld %u %d", index, seed + (unsigned)(index % flag_systems),
+                flag_moons);
+        if (sweep_type != SWEEP_NONE) {
+            strcat(task, " ");
+            sweep_point(index / flag_systems, task + strlen(task));
+        }
+        strcat(task, "\n");
+        return(TRUE);
+    }
+    while (fgets(line, sizeof(line) - 32, manifest) != NULL) {
+        manifest_line++;
+        if ((strchr(line, '\n') == NULL) && !feof(manifest)) {
+            fprintf(stderr, "ERROR: manifest line %ld is too long\n", manifest_line);
+            manifest_errors++;
+            while ((fgets(line, sizeof(line), manifest) != NULL)
+                   && (strchr(line, '\n') == NULL))
+                ;
+            continue;
+        }
+        if ((line[strspn(line, " \t\r\n")] == '\0')
+            || (line[strspn(line, " \t")] == '#'))
+            continue;
+        if (!read_manifest_line(line, rest)) {
+            manifest_errors++;
+            continue;
+        }
+        sprintf(task, "%ld %s\n", index, rest);
+        return(TRUE);
+    }
+    return(FALSE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Generate the system a task line asks for, returning its description    */
+/*   as 'capture_system' does.  The index is returned in 'index'.  Words    */
+/*   of the task such as "alpha=4.5" set parameters for this system only;   */
+/*   the rest are its stars.  A snapshot is finished with the parameters    */
+/*   it was made with, unless they were given with -p.                      */
+/*--------------------------------------------------------------------------*/
+char *run_task(char *task, long *index, long *length)
+{
+    char stars[TASK_LINE_SIZE];
+    char *word;
+    star_pointer command_line_stars;
+    physics_params command_line_physics;
+    int command_line_startype, offset;
+    unsigned seed;
+    char *text;
+
+    offset = 0;
+    if ((sscanf(task, "%ld snapshot%n", index, &offset) == 1) && (offset > 0)) {
+        system_index = *index;
+        command_line_physics = physics;
+        if (load_snapshot(strchr(task, '\n') + 1, &seed)) {
+            text = capture_system(seed, length);
+        }
+        else if ((text = (char *)calloc(1, 1)) != NULL) {
+            *length = 0;
+        }
+        else {
+            perror("malloc'ing a system record");
+            exit(1);
+        }
+        physics = command_line_physics;
+        system_tag[0] = '\0';
+        return(text);
+    }
+    if (sscanf(task, "%ld %u %d%n", index, &seed, &flag_moons, &offset) != 3) {
+        fprintf(stderr, "ERROR: bad task line <%s>\n", task);
+        exit(1);
+    }
+    system_index = *index;
+    command_line_stars = star_specs;
+    command_line_startype = flag_startype;
+    command_line_physics = physics;
+    stars[0] = '\0';
+    system_tag[0] = '\0';
+    for (word = strtok(task + offset, " \n"); word != NULL; word = strtok(NULL, " \n")) {
+        if (strchr(word, '=') == NULL) {
+            if (strlen(stars) + strlen(word) + 2 > sizeof(stars)) {
+                fprintf(stderr, "ERROR: too many stars in task line\n");
+                exit(1);
+            }
+            strcat(stars, " ");
+            strcat(stars, word);
+        }
+        else if (set_parameter(word)) {
+            if (strlen(system_tag) + strlen(word) + 2 > TASK_LINE_SIZE) {
+                fprintf(stderr, "ERROR: too many parameters in task line\n");
+                exit(1);
+            }
+            if (system_tag[0] != '\0')
+                strcat(system_tag, " ");
+            strcat(system_tag, word);
+        }
+        else {
+            fprintf(stderr, "ERROR: bad parameter <%s> in task line\n", word);
+            exit(1);
+        }
+    }
+    if (stars[0] != '\0') {
+        if (!read_star_list(stars, &star_specs)) {
+            fprintf(stderr, "ERROR: bad stars in task line <%s>\n", stars);
+            exit(1);
+        }
+        flag_startype = TRUE;
+    }
+    text = capture_system(seed, length);
+    if (star_specs != command_line_stars) {
+        free_star_list(star_specs);
+        star_specs = command_line_stars;
+        flag_startype = command_line_startype;
+    }
+    physics = command_line_physics;
+    system_tag[0] = '\0';
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Send whatever is written to 'display_file' into memory, until          */
+/*   'end_capture' hands it back in a newly allocated buffer and puts       */
+/*   'display_file' back as it was.                                         */
+/*--------------------------------------------------------------------------*/
+void begin_capture(capture_info *capture)
+{
+    capture->saved = display_file;
+#ifdef MULTIPROC
+    if ((display_file = open_memstream(&capture->text, &capture->size)) == NULL) {
+        perror("opening a memory stream for a system");
+        exit(1);
+    }
+#else
+    if ((display_file = tmpfile()) == NULL) {
+        perror("opening a scratch file for a system");
+        exit(1);
+    }
+#endif
+}
+
+char *end_capture(capture_info *capture, long *length)
+{
+    char *text;
+
+#ifdef MULTIPROC
+    fclose(display_file);
+    text = capture->text;
+    *length = (long)capture->size;
+#else
+    *length = ftell(display_file);
+    rewind(display_file);
+    if ((text = (char *)malloc((size_t)*length + 1)) == NULL) {
+        perror("malloc'ing a system record");
+        exit(1);
+    }
+    *length = (long)fread(text, 1, (size_t)*length, display_file);
+    text[*length] = '\0';
+    fclose(display_file);
+#endif
+    display_file = capture->saved;
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Generate the system for one seed, returning its description in a       */
+/*   newly allocated buffer rather than writing it out.                     */
+/*--------------------------------------------------------------------------*/
+char *capture_system(unsigned seed, long *length)
+{
+    capture_info capture;
+
+    begin_capture(&capture);
+    make_system(seed);
+    return(end_capture(&capture, length));
+}
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   Write or read exactly 'length' bytes, riding out interrupted calls.    */
+/*--------------------------------------------------------------------------*/
+void write_full(int fd, char *buf, long length)
+{
+    long done;
+
+    while (length > 0) {
+        if ((done = write(fd, buf, (size_t)length)) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("writing a system record");
+            exit(1);
+        }
+        buf += done;
+        length -= done;
+    }
+}
+
+int read_full(int fd, char *buf, long length)
+{
+    long done;
+
+    while (length > 0) {
+        if ((done = read(fd, buf, (size_t)length)) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("reading a system record");
+            exit(1);
+        }
+        if (done == 0)
+            return(FALSE);
+        buf += done;
+        length -= done;
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The worker side of a batch run.  Each line read from 'task_fd' names   */
+/*   a system (see 'next_task_line').  The description of                   */
+/*   the system is built up in memory and sent back on 'result_fd' as a     */
+/*   single record.  The worker exits when its task pipe is closed.         */
+/*--------------------------------------------------------------------------*/
+void run_worker(int task_fd, int result_fd)
+{
+    FILE *tasks;
+    char line[SNAPSHOT_SIZE];
+    record_header header;
+    char *text;
+    long index;
+    int offset;
+
+    if (flag_journal != NULL) {
+        /*
+         *  Leave it to the parent to stop the batch cleanly:
+         */
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, SIG_IGN);
+    }
+    if ((tasks = fdopen(task_fd, "r")) == NULL) {
+        perror("opening the task pipe");
+        exit(1);
+    }
+    while (fgets(line, TASK_LINE_SIZE, tasks) != NULL) {
+        /*
+         *  A snapshot follows its task line:
+         */
+        offset = 0;
+        if ((sscanf(line, "%ld snapshot%n", &index, &offset) == 1) && (offset > 0)
+            && !read_snapshot_text(tasks, line + strlen(line),
+                                   SNAPSHOT_SIZE - (long)strlen(line))) {
+            fprintf(stderr, "ERROR: snapshot %ld was cut short\n", index);
+            exit(1);
+        }
+        text = run_task(line, &header.index, &header.length);
+        header.tripped = budget.tripped;
+        header.rejected = search_rejected;
+        memcpy(header.targets, system_targets, sizeof(header.targets));
+        write_full(result_fd, (char *)&header, (long)sizeof(header));
+        write_full(result_fd, text, header.length);
+        free(text);
+    }
+    send_summaries(result_fd);
+    exit(0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Start worker 'which', with a pipe for tasks going out and a pipe for   */
+/*   finished systems coming back.  The first 'count' workers are already   */
+/*   running, and the new one closes its copies of their pipes.             */
+/*--------------------------------------------------------------------------*/
+void start_worker(worker_info *workers, int which, int count)
+{
+    int task_pipe[2], result_pipe[2];
+    int j;
+
+    fflush(stdout);
+    if ((pipe(task_pipe) < 0) || (pipe(result_pipe) < 0)) {
+        perror("creating worker pipes");
+        exit(1);
+    }
+    if ((workers[which].pid = fork()) < 0) {
+        perror("forking a worker process");
+        exit(1);
+    }
+    if (workers[which].pid == 0) {
+        /*
+         *  The worker doesn't need the parent's ends of any pipes:
+         */
+        for (j = 0; j < count; j++) {
+            if (j == which)
+                continue;
+            if (workers[j].task_fd >= 0)
+                close(workers[j].task_fd);
+            close(workers[j].result_fd);
+        }
+        close(task_pipe[1]);
+        close(result_pipe[0]);
+        run_worker(task_pipe[0], result_pipe[1]);
+    }
+    close(task_pipe[0]);
+    close(result_pipe[1]);
+    workers[which].task_fd = task_pipe[1];
+    workers[which].result_fd = result_pipe[0];
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Start 'count' worker processes.                                        */
+/*--------------------------------------------------------------------------*/
+void start_workers(worker_info *workers, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        memset(&workers[i], 0, sizeof(worker_info));
+        start_worker(workers, i, i);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the next finished system from a worker.  The text is returned in  */
+/*   a newly allocated buffer.  'fetch_record' returns NULL if the worker   */
+/*   has died, and 'read_record' gives up.                                  */
+/*--------------------------------------------------------------------------*/
+char *fetch_record(worker_info *worker, record_header *header)
+{
+    char *text;
+
+    if (!read_full(worker->result_fd, (char *)header, (long)sizeof(*header)))
+        return(NULL);
+    if ((text = (char *)malloc((size_t)header->length + 1)) == NULL) {
+        perror("malloc'ing a system record");
+        exit(1);
+    }
+    if (!read_full(worker->result_fd, text, header->length)) {
+        free(text);
+        return(NULL);
+    }
+    return(text);
+}
+
+char *read_record(worker_info *worker, record_header *header)
+{
+    char *text;
+
+    if ((text = fetch_record(worker, header)) == NULL) {
+        fprintf(stderr, "ERROR: worker %ld quit unexpectedly\n", worker->pid);
+        exit(1);
+    }
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   In a census, a ranking or a sample, each worker sends back its census, */
+/*   its best planets and its samples once its task pipe is closed, as      */
+/*   last records with indexes of RECORD_CENSUS, RECORD_RANKING and         */
+/*   RECORD_SAMPLE.  The census is sent as text (see census.c) and the      */
+/*   planets just as they are.  Each sample is sent as a record giving the  */
+/*   systems of its kind made, how many were kept and its name, followed by */
+/*   a record for each system kept, giving its key and place in the batch   */
+/*   on a line before its description; an empty record ends them.  The      */
+/*   parent merges them all and writes out the results in place of the      */
+/*   systems.  A shard (see shard.c) writes its merged results out in the   */
+/*   same form, which is what a 'result_fd' of -1 asks for.                 */
+/*--------------------------------------------------------------------------*/
+void send_bytes(int result_fd, char *buf, long length)
+{
+    if (result_fd < 0)
+        emit_record(buf, length);
+    else write_full(result_fd, buf, length);
+}
+
+void send_record(int result_fd, long index, char *text, long length)
+{
+    record_header header;
+
+    memset(&header, 0, sizeof(header));
+    header.index = index;
+    header.length = length;
+    header.rejected = REJECTED_NONE;
+    send_bytes(result_fd, (char *)&header, (long)sizeof(header));
+    send_bytes(result_fd, text, length);
+}
+
+void send_summaries(int result_fd)
+{
+    record_header header;
+    sampled_system *entry;
+    char line[SNAPSHOT_LINE_SIZE];
+    char *text;
+    size_t size;
+    long i;
+    FILE *fp;
+    int k;
+
+    memset(&header, 0, sizeof(header));
+    header.rejected = REJECTED_NONE;
+    if (flag_census != NULL) {
+        if ((fp = open_memstream(&text, &size)) == NULL) {
+            perror("opening a memory stream for the census");
+            exit(1);
+        }
+        write_census(fp);
+        fclose(fp);
+        send_record(result_fd, RECORD_CENSUS, text, (long)size);
+        free(text);
+    }
+    if (flag_top > 0) {
+        send_record(result_fd, RECORD_RANKING, (char *)ranking,
+                    ranking_count * (long)sizeof(ranked_planet));
+    }
+    if (flag_sample > 0) {
+        for (k = 0; k < stratum_count; k++) {
+            sprintf(line, "%ld %ld %s", strata[k].systems, strata[k].count, strata[k].name);
+            send_record(result_fd, RECORD_SAMPLE, line, (long)strlen(line));
+            for (i = 0; i < strata[k].count; i++) {
+                entry = &strata[k].kept[i];
+                sprintf(line, "%lu %ld\n", entry->key, entry->index);
+                header.index = RECORD_SAMPLE;
+                header.length = (long)strlen(line) + entry->length;
+                send_bytes(result_fd, (char *)&header, (long)sizeof(header));
+                send_bytes(result_fd, line, (long)strlen(line));
+                send_bytes(result_fd, entry->text, entry->length);
+            }
+        }
+        send_record(result_fd, RECORD_SAMPLE, line, 0L);
+    }
+    if (flag_timing != NULL) {
+        send_record(result_fd, RECORD_TIMING, (char *)stage_histograms,
+                    TIMING_STAGES * (long)sizeof(timing_histogram));
+    }
+}
+
+void collect_samples(worker_info *worker)
+{
+    record_header header;
+    sample_stratum *stratum;
+    sampled_system entry;
+    char name[STRATUM_NAME_SIZE];
+    char *text;
+    long systems, kept, i;
+    int offset;
+
+    for (;;) {
+        text = read_record(worker, &header);
+        text[header.length] = '\0';
+        if (header.length == 0) {
+            free(text);
+            return;
+        }
+        offset = 0;
+        if ((sscanf(text, "%ld %ld %n", &systems, &kept, &offset) != 2) || (offset == 0)) {
+            fprintf(stderr, "ERROR: bad sample from worker %ld\n", worker->pid);
+            exit(1);
+        }
+        strncpy(name, text + offset, STRATUM_NAME_SIZE - 1);
+        name[STRATUM_NAME_SIZE - 1] = '\0';
+        free(text);
+        stratum = find_stratum(name);
+        stratum->systems += systems;
+        for (i = 0; i < kept; i++) {
+            text = read_record(worker, &header);
+            text[header.length] = '\0';
+            offset = 0;
+            if ((sscanf(text, "%lu %ld\n%n", &entry.key, &entry.index, &offset) != 2)
+                || (offset == 0)) {
+                fprintf(stderr, "ERROR: bad sample from worker %ld\n", worker->pid);
+                exit(1);
+            }
+            entry.length = header.length - offset;
+            memmove(text, text + offset, (size_t)entry.length + 1);
+            entry.text = text;
+            offer_sample(stratum, &entry);
+        }
+    }
+}
+
+void collect_summaries(worker_info *workers, int count)
+{
+    record_header header;
+    ranked_planet *planets;
+    timing_histogram *histograms;
+    char *text;
+    long j;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (flag_census != NULL) {
+            text = read_record(&workers[i], &header);
+            merge_census_text(text, header.length);
+            free(text);
+        }
+        if (flag_top > 0) {
+            planets = (ranked_planet *)read_record(&workers[i], &header);
+            for (j = 0; j < header.length / (long)sizeof(ranked_planet); j++)
+                offer_planet(&planets[j]);
+            free(planets);
+        }
+        if (flag_sample > 0)
+            collect_samples(&workers[i]);
+        if (flag_timing != NULL) {
+            histograms = (timing_histogram *)read_record(&workers[i], &header);
+            if (header.length != TIMING_STAGES * (long)sizeof(timing_histogram)) {
+                fprintf(stderr, "ERROR: bad timing from worker %ld\n", workers[i].pid);
+                exit(1);
+            }
+            merge_timing(histograms);
+            free(histograms);
+        }
+    }
+}
+
+void write_summaries(void)
+{
+    char *text;
+    size_t size;
+    FILE *fp;
+
+    if ((fp = open_memstream(&text, &size)) == NULL) {
+        perror("opening a memory stream for the results");
+        exit(1);
+    }
+    if (flag_sample > 0)
+        write_sample(fp);
+    if (flag_census != NULL)
+        finish_census(fp);
+    if (flag_top > 0)
+        write_ranking(fp);
+    fclose(fp);
+    emit_record(text, (long)size);
+    free(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The parent side of a batch run.  Systems are handed out to the         */
+/*   workers a few at a time (enough to keep each one busy without ever     */
+/*   filling a task pipe).                                                  */
+/*                                                                          */
+/*   Workers finish their systems in no particular order, so finished       */
+/*   systems are held in a reorder window and written strictly in seed      */
+/*   order.  Output is then identical whatever the number of workers.  No   */
+/*   system is handed out until it fits in the window, so a worker stuck    */
+/*   on a slow system holds the others back rather than letting the window  */
+/*   grow without limit.  With '-u' systems are written as they arrive.     */
+/*                                                                          */
+/*   With '-c' each system's values are added to the targets as it is       */
+/*   written out, and once they have converged no more systems are handed   */
+/*   out; those already under way are thrown away as they come back.        */
+/*                                                                          */
+/*   With '-l' the journal is brought up to date every so often, and the    */
+/*   batch stops cleanly if it is interrupted (see journal.c).  With '-q'   */
+/*   a worker that dies or hangs is replaced (see supervise.c).             */
+/*--------------------------------------------------------------------------*/
+void generate_batch(void)
+{
+    worker_info *workers;
+    struct pollfd *polls;
+    record_header header;
+    char line[SNAPSHOT_SIZE];
+    char *text;
+    char **window_text;
+    record_header *window_header;
+    unsigned seed;
+    long next_task, next_emit, finished, window, slot;
+    int i, ready, open_tasks, more_tasks;
+
+    if (flag_journal != NULL)
+        open_journal();
+    seed = first_seed();
+    open_manifest();
+    open_catalog();
+    make_sweep(seed);
+    open_output();
+    if (resume_bytes == 0) {
+        /*
+         *  (A batch being carried on has its heading already.)
+         */
+        if (flag_shards > 0)
+            start_shard();
+        else {
+            sprintf(line, "Starform - V%s\n", VERSION);
+            emit_record(line, (long)strlen(line));
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if ((window = flag_window) == 0) {
+        window = (long)flag_workers * WORKER_QUEUE_DEPTH * 4;
+    }
+    if (((workers = (worker_info *)malloc(flag_workers * sizeof(worker_info))) == NULL)
+        || ((polls = (struct pollfd *)malloc(flag_workers * sizeof(struct pollfd))) == NULL)
+        || ((window_text = (char **)calloc((size_t)window, sizeof(char *))) == NULL)
+        || ((window_header = (record_header *)calloc((size_t)window,
+                                                     sizeof(record_header))) == NULL)) {
+        perror("malloc'ing worker information");
+        exit(1);
+    }
+    start_workers(workers, flag_workers);
+
+    next_task = 0;
+    next_emit = 0;
+    finished = 0;
+    open_tasks = TRUE;
+    more_tasks = TRUE;
+    if (flag_journal != NULL) {
+        /*
+         *  Skip the systems already written out (reading past them in
+         *  any manifest or catalog):
+         */
+        while (more_tasks && (next_task < resume_place))
+            more_tasks = next_shard_line(next_task++, seed, line);
+        next_emit = next_task;
+        finished = next_task;
+        start_journal(seed);
+    }
+    for (;;) {
+        if (stop_signal != 0)
+            stop_batch(workers, flag_workers, next_emit);
+        /*
+         *  Top up each worker's queue of tasks:
+         */
+        for (i = 0; i < flag_workers; i++) {
+            while (more_tasks
+                   && (workers[i].in_flight < WORKER_QUEUE_DEPTH)
+                   && (flag_unordered || (next_task < next_emit + window))) {
+                if (!(more_tasks = next_shard_line(next_task, seed, line)))
+                    break;
+                send_task(&workers[i], line);
+                next_task++;
+            }
+        }
+        if (open_tasks && !more_tasks) {
+            for (i = 0; i < flag_workers; i++) {
+                close(workers[i].task_fd);
+                workers[i].task_fd = -1;
+            }
+            open_tasks = FALSE;
+        }
+        if (!more_tasks && (finished == next_task))
+            break;
+        /*
+         *  Wait for any of the busy workers to finish a system:
+         */
+        for (i = 0; i < flag_workers; i++) {
+            polls[i].fd = (workers[i].in_flight > 0) ? workers[i].result_fd : -1;
+            polls[i].events = POLLIN;
+            polls[i].revents = 0;
+        }
+        if ((ready = poll(polls, (nfds_t)flag_workers,
+                          hang_timeout(workers, flag_workers))) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("waiting for workers");
+            exit(1);
+        }
+        kill_hung_workers(workers, flag_workers);
+        for (i = 0; (i < flag_workers) && (ready > 0); i++) {
+            if (polls[i].revents == 0)
+                continue;
+            ready--;
+            text = next_record(workers, i, &header, open_tasks);
+            finished++;
+            if (converged_at > 0) {
+                free(text);
+                continue;
+            }
+            if (flag_unordered) {
+                note_truncation(header.tripped);
+                note_search(header.rejected);
+                emit_record(text, header.length);
+                free(text);
+                if ((target_count > 0) && add_targets(header.targets))
+                    more_tasks = FALSE;
+                continue;
+            }
+            slot = shard_place(header.index) % window;
+            window_text[slot] = text;
+            window_header[slot] = header;
+            /*
+             *  Write out as many systems as are now ready in order:
+             */
+            while ((converged_at == 0) && (window_text[slot = next_emit % window] != NULL)) {
+                note_truncation(window_header[slot].tripped);
+                note_search(window_header[slot].rejected);
+                emit_system(&window_header[slot], window_text[slot]);
+                free(window_text[slot]);
+                window_text[slot] = NULL;
+                next_emit++;
+                if ((target_count > 0) && add_targets(window_header[slot].targets))
+                    more_tasks = FALSE;
+            }
+            if ((flag_journal != NULL) && journal_due())
+                commit_journal(next_emit);
+        }
+    }
+    if ((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0)
+        || (flag_timing != NULL))
+        collect_summaries(workers, flag_workers);
+    if (flag_shards > 0)
+        end_shard();
+    else if ((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0))
+        write_summaries();
+    if (flag_journal != NULL)
+        finish_journal(next_emit);
+    close_output();
+    report_truncation();
+    report_search();
+    report_convergence();
+    report_quarantine();
+    if (manifest_errors > 0) {
+        fprintf(stderr, "%ld bad manifest lines skipped\n", manifest_errors);
+    }
+    for (i = 0; i < flag_workers; i++) {
+        close(workers[i].result_fd);
+        waitpid(workers[i].pid, NULL, 0);
+    }
+    report_timing();
+    for (slot = 0; slot < window; slot++)
+        free(window_text[slot]);
+    free(window_header);
+    free(window_text);
+    free(polls);
+    free(workers);
+}
+
+#else /* MULTIPROC */
+
+/*--------------------------------------------------------------------------*/
+/*   Without fork() the systems are simply built one after another.         */
+/*--------------------------------------------------------------------------*/
+void generate_batch(void)
+{
+    char line[SNAPSHOT_SIZE];
+    unsigned seed;
+    long i, length;
+    char *text;
+
+    if (flag_compress || (flag_shards > 0) || (flag_journal != NULL)
+        || (flag_quarantine != NULL)) {
+        fprintf(stderr, "ERROR: -z, -H, -l and -q are only available where starform "
+                        "can fork\n");
+        exit(1);
+    }
+    seed = first_seed();
+    open_manifest();
+    open_catalog();
+    make_sweep(seed);
+    printf("Starform - V%s\n", VERSION);
+    for (i = 0; next_task_line(i, seed, line); i++) {
+        text = run_task(line, &i, &length);
+        fwrite(text, 1, (size_t)length, stdout);
+        free(text);
+        note_truncation(budget.tripped);
+        note_search(search_rejected);
+        if ((target_count > 0) && add_targets(system_targets))
+            break;
+    }
+    if (flag_sample > 0)
+        write_sample(stdout);
+    if (flag_census != NULL)
+        finish_census(stdout);
+    if (flag_top > 0)
+        write_ranking(stdout);
+    report_truncation();
+    report_search();
+    report_convergence();
+    if (manifest_errors > 0) {
+        fprintf(stderr, "%ld bad manifest lines skipped\n", manifest_errors);
+    }
+    report_timing();
+}
+
+#endif /* MULTIPROC */
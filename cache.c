@@ -0,0 +1,274 @@
+/*----------------------------------------------------------------------*/
+/*                               cache.c                                */
+/*                                                                      */
+/*  A cache of finished systems for the server (the -C and -D flags).   */
+/*  A system is completely determined by its seed, its stars and        */
+/*  whether moons were built, so the description generated for one     */
+/*  request can be handed straight back to any later request asking    */
+/*  for the same thing.  Systems are kept in memory up to a budget,     */
+/*  throwing out the least recently used first, and may also be kept   */
+/*  on disk so that they survive the server being restarted.            */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern long flag_cache_size;
+extern char *flag_cache_dir;
+
+/*
+ *  The memory cache is a hash table of entries which are also linked,
+ *  most recently used first, into a single list:
+ */
+cache_pointer cache_table[CACHE_TABLE_SIZE];
+cache_pointer cache_newest = NULL;
+cache_pointer cache_oldest = NULL;
+
+/*
+ *  How well the cache is doing:
+ */
+long cache_hits = 0;
+long cache_disk_hits = 0;
+long cache_misses = 0;
+long cache_evictions = 0;
+long cache_entries = 0;
+long cache_bytes = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   The FNV-1a hash of a key.                                              */
+/*--------------------------------------------------------------------------*/
+unsigned long cache_hash(char *key)
+{
+    unsigned long hash = 2166136261UL;
+
+    while (*key != '\0') {
+        hash ^= (unsigned char)*key++;
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return(hash);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Take an entry out of the most-recently-used list, or put it at the     */
+/*   front of it.                                                           */
+/*--------------------------------------------------------------------------*/
+void cache_unlink(cache_pointer entry)
+{
+    if (entry->newer != NULL)
+        entry->newer->older = entry->older;
+    else cache_newest = entry->older;
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else cache_oldest = entry->newer;
+    entry->newer = entry->older = NULL;
+}
+
+void cache_make_newest(cache_pointer entry)
+{
+    entry->older = cache_newest;
+    entry->newer = NULL;
+    if (cache_newest != NULL)
+        cache_newest->newer = entry;
+    cache_newest = entry;
+    if (cache_oldest == NULL)
+        cache_oldest = entry;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Throw out the least recently used entry.                               */
+/*--------------------------------------------------------------------------*/
+void cache_evict(void)
+{
+    cache_pointer entry, *link;
+
+    if ((entry = cache_oldest) == NULL)
+        return;
+    cache_unlink(entry);
+    for (link = &cache_table[entry->hash % CACHE_TABLE_SIZE];
+         *link != entry;
+         link = &((*link)->next_entry))
+        ;
+    *link = entry->next_entry;
+    cache_bytes -= entry->length + (long)strlen(entry->key);
+    cache_entries--;
+    cache_evictions++;
+    free(entry->key);
+    free(entry->text);
+    free(entry);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The name of the disk file that holds the system for 'hash'.            */
+/*--------------------------------------------------------------------------*/
+void cache_file_name(char *name, unsigned long hash)
+{
+    sprintf(name, "%.*s/%08lx.sys", CACHE_NAME_SIZE - 16, flag_cache_dir, hash);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Look for a system on disk.  The first line of each file is the key it  */
+/*   was stored under, in case two keys share a hash.                       */
+/*--------------------------------------------------------------------------*/
+char *cache_read_disk(char *key, unsigned long hash, long *length)
+{
+    char name[CACHE_NAME_SIZE];
+    char line[SERVER_LINE_SIZE];
+    char *text;
+    long start;
+    FILE *fp;
+
+    cache_file_name(name, hash);
+    if ((fp = fopen(name, "rb")) == NULL)
+        return(NULL);
+    if ((fgets(line, sizeof(line), fp) == NULL)
+        || (strncmp(line, key, strlen(key)) != 0)
+        || (line[strlen(key)] != '\n')) {
+        fclose(fp);
+        return(NULL);
+    }
+    start = ftell(fp);
+    fseek(fp, 0L, SEEK_END);
+    *length = ftell(fp) - start;
+    fseek(fp, start, SEEK_SET);
+    if ((text = (char *)malloc((size_t)*length + 1)) == NULL) {
+        perror("malloc'ing a cached system");
+        exit(1);
+    }
+    if (fread(text, 1, (size_t)*length, fp) != (size_t)*length) {
+        free(text);
+        fclose(fp);
+        return(NULL);
+    }
+    fclose(fp);
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Store a system on disk.  It is written under a temporary name first,   */
+/*   so that a reader never sees half a file.                               */
+/*--------------------------------------------------------------------------*/
+void cache_write_disk(char *key, unsigned long hash, char *text, long length)
+{
+    char name[CACHE_NAME_SIZE];
+    char temp_name[CACHE_NAME_SIZE + 16];
+    FILE *fp;
+
+    cache_file_name(name, hash);
+    sprintf(temp_name, "%s.%u", name, random_seed());
+    if ((fp = fopen(temp_name, "wb")) == NULL)
+        return;
+    fprintf(fp, "%s\n", key);
+    if ((fwrite(text, 1, (size_t)length, fp) != (size_t)length)
+        || (fclose(fp) != 0)) {
+        remove(temp_name);
+        return;
+    }
+    if (rename(temp_name, name) != 0)
+        remove(temp_name);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add a system to the memory cache, making room for it if need be.       */
+/*--------------------------------------------------------------------------*/
+void cache_insert(char *key, unsigned long hash, char *text, long length)
+{
+    cache_pointer entry;
+    long size;
+
+    size = length + (long)strlen(key);
+    if (size > flag_cache_size)
+        return;
+    while (cache_bytes + size > flag_cache_size)
+        cache_evict();
+    if (((entry = (cache_entry *)malloc(sizeof(cache_entry))) == NULL)
+        || ((entry->key = (char *)malloc(strlen(key) + 1)) == NULL)
+        || ((entry->text = (char *)malloc((size_t)length)) == NULL)) {
+        perror("malloc'ing a cache entry");
+        exit(1);
+    }
+    strcpy(entry->key, key);
+    memcpy(entry->text, text, (size_t)length);
+    entry->length = length;
+    entry->hash = hash;
+    entry->next_entry = cache_table[hash % CACHE_TABLE_SIZE];
+    cache_table[hash % CACHE_TABLE_SIZE] = entry;
+    cache_make_newest(entry);
+    cache_entries++;
+    cache_bytes += size;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Look up the system stored under 'key'.  A copy of its description is   */
+/*   returned in a newly allocated buffer, or NULL if it isn't cached.      */
+/*--------------------------------------------------------------------------*/
+char *cache_lookup(char *key, long *length)
+{
+    cache_pointer entry;
+    unsigned long hash;
+    char *text;
+
+    hash = cache_hash(key);
+    for (entry = cache_table[hash % CACHE_TABLE_SIZE];
+         entry != NULL;
+         entry = entry->next_entry) {
+        if ((entry->hash == hash) && (strcmp(entry->key, key) == 0)) {
+            cache_unlink(entry);
+            cache_make_newest(entry);
+            if ((text = (char *)malloc((size_t)entry->length + 1)) == NULL) {
+                perror("malloc'ing a cached system");
+                exit(1);
+            }
+            memcpy(text, entry->text, (size_t)entry->length);
+            *length = entry->length;
+            cache_hits++;
+            return(text);
+        }
+    }
+    if ((flag_cache_dir != NULL)
+        && ((text = cache_read_disk(key, hash, length)) != NULL)) {
+        cache_disk_hits++;
+        if (flag_cache_size > 0)
+            cache_insert(key, hash, text, *length);
+        return(text);
+    }
+    cache_misses++;
+    return(NULL);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Remember a newly generated system.                                     */
+/*--------------------------------------------------------------------------*/
+void cache_store(char *key, char *text, long length)
+{
+    unsigned long hash;
+
+    hash = cache_hash(key);
+    if (flag_cache_size > 0)
+        cache_insert(key, hash, text, length);
+    if (flag_cache_dir != NULL)
+        cache_write_disk(key, hash, text, length);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Report on the cache as the fields of a JSON object.                    */
+/*--------------------------------------------------------------------------*/
+void cache_report(FILE *fp)
+{
+    long lookups;
+
+    lookups = cache_hits + cache_disk_hits + cache_misses;
+    fprintf(fp, "\"cache_hits\": %ld, \"cache_disk_hits\": %ld, "
+                "\"cache_misses\": %ld, \"cache_hit_rate\": %.4f, "
+                "\"cache_evictions\": %ld, \"cache_entries\": %ld, "
+                "\"cache_bytes\": %ld",
+            cache_hits, cache_disk_hits, cache_misses,
+            (lookups > 0) ? (double)(cache_hits + cache_disk_hits) / lookups : 0.0,
+            cache_evictions, cache_entries, cache_bytes);
+}
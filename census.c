@@ -0,0 +1,504 @@
+/*----------------------------------------------------------------------*/
+/*                               census.c                               */
+/*                                                                      */
+/*  Statistics of a whole batch in place of its systems (the -a flag).  */
+/*  For a census of many systems only the totals matter: how many       */
+/*  planets each has, how their masses and orbits are spread, what      */
+/*  fraction are gas giants or have a runaway greenhouse effect, and    */
+/*  so on, for all the systems and for each kind of primary star.       */
+/*                                                                      */
+/*  Each statistic keeps a count, mean and variance (updated a value    */
+/*  at a time, after Welford), the smallest and largest values, and a   */
+/*  histogram of fixed bins from which its quantiles are read off.      */
+/*  All of these can be merged, and the histograms merge exactly in     */
+/*  any order, so each worker process keeps a census of the systems it  */
+/*  made, the censuses are merged when the batch is over, and the       */
+/*  result is the same however many processes made the batch.  A census */
+/*  can also be saved to a file with '-a<file>' and merged into that of */
+/*  another run (with '-I'), so a study split over several runs or      */
+/*  machines comes out as one.                                          */
+/*                                                                      */
+/*  Where primaries are chosen by weight (the -W flag), each value      */
+/*  counts for the weight of its system, so the means, quantiles and    */
+/*  histograms are those of the natural population.                     */
+/*                                                                      */
+/*  A saved census is text, one statistic to a line:                    */
+/*                                                                      */
+/*      group 120 K V                                                   */
+/*      stat planets 120 9.35 642.1 3 17 120 120                        */
+/*      bins planets 0 0 0 1 12 ...                                     */
+/*                                                                      */
+/*  giving the systems in each group, then for each statistic its       */
+/*  count, mean, sum of squared differences from the mean, smallest     */
+/*  and largest, and the total of the weights and of their squares;     */
+/*  and its histogram (below the range, the bins, and above the range). */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <math.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern char *flag_census;
+extern double system_weight;
+
+/*
+ *  The statistics kept, with the range of their histograms:
+ */
+census_info census_table[CENSUS_STATS] = {
+	{"planets",     0.0,   40.0, FALSE, TRUE},  /* planets per system      */
+	{"gas_giants",  0.0,    1.0, FALSE, TRUE},  /* 1 for a gas giant, or 0 */
+	{"mass",       -6.0,    4.0, TRUE,  FALSE}, /* Earth masses            */
+	{"a",          -2.0,    3.0, TRUE,  FALSE}, /* AU                      */
+	{"e",           0.0,    1.0, FALSE, FALSE},
+	{"greenhouse",  0.0,    1.0, FALSE, TRUE},  /* rocky planets, 1 or 0   */
+	{"surf_temp",   0.0, 1000.0, FALSE, FALSE}, /* rocky planets, Kelvin   */
+	{"moons",       0.0,   40.0, FALSE, TRUE}   /* moons per planet        */
+};
+
+/*
+ *  The census so far, and the saved censuses to be added to it:
+ */
+census_group census_groups[MAX_CENSUS_GROUPS];
+int census_group_count = 0;
+census_group *counted_groups[2];        /* those of the system being counted */
+char *census_inputs[MAX_CENSUS_INPUTS];
+int census_input_count = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Add a value, with its weight, to the count, mean and variance of       */
+/*   'moments' (after West), or merge 'other' into them (after Chan, Golub  */
+/*   and LeVeque).                                                          */
+/*--------------------------------------------------------------------------*/
+void add_moment(running_stat *moments, double value, double weight)
+{
+    double delta;
+
+    if ((moments->count == 0) || (value < moments->min))
+        moments->min = value;
+    if ((moments->count == 0) || (value > moments->max))
+        moments->max = value;
+    moments->count++;
+    moments->weight += weight;
+    moments->weight2 += weight * weight;
+    delta = value - moments->mean;
+    moments->mean += delta * weight / moments->weight;
+    moments->m2 += weight * delta * (value - moments->mean);
+}
+
+void merge_moments(running_stat *moments, running_stat *other)
+{
+    double delta, weight;
+
+    if (other->count == 0)
+        return;
+    if ((moments->count == 0) || (other->min < moments->min))
+        moments->min = other->min;
+    if ((moments->count == 0) || (other->max > moments->max))
+        moments->max = other->max;
+    weight = moments->weight + other->weight;
+    delta = other->mean - moments->mean;
+    moments->mean += delta * other->weight / weight;
+    moments->m2 += other->m2 + delta * delta * (moments->weight * other->weight) / weight;
+    moments->count += other->count;
+    moments->weight = weight;
+    moments->weight2 += other->weight2;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Where a value lies on the scale of a statistic's histogram: the value  */
+/*   itself, or its log10 for one binned by that.                           */
+/*--------------------------------------------------------------------------*/
+double census_place(census_info *info, double value)
+{
+    if (!info->log_scale)
+        return(value);
+    return((value > 0.0) ? log10(value) : info->low - 1.0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the quantile 'q' (0 to 1) of a statistic off its histogram,       */
+/*   taking the values in each bin to be spread evenly across it.  The      */
+/*   bins at either end reach out to the smallest and largest values seen.  */
+/*   The bins are narrower than one, so a count is exact: it is the whole   */
+/*   number at the bottom of its bin.                                       */
+/*--------------------------------------------------------------------------*/
+double census_quantile(census_stat *stat, census_info *info, double q)
+{
+    double total, target, cumulative, width, bottom, top, lowest, highest, place;
+    int k;
+
+    total = 0.0;
+    for (k = 0; k < CENSUS_BINS + 2; k++)
+        total += stat->bins[k];
+    if (total <= 0.0)
+        return(stat->moments.min);
+    target = q * total;
+    cumulative = 0.0;
+    for (k = 0; k < CENSUS_BINS + 1; k++) {
+        if ((stat->bins[k] > 0.0) && (cumulative + stat->bins[k] >= target))
+            break;
+        cumulative += stat->bins[k];
+    }
+    lowest = census_place(info, stat->moments.min);
+    highest = census_place(info, stat->moments.max);
+    width = (info->high - info->low) / CENSUS_BINS;
+    bottom = (k == 0) ? lowest : info->low + (k - 1) * width;
+    top = (k == CENSUS_BINS + 1) ? highest : info->low + k * width;
+    if (bottom < lowest)
+        bottom = lowest;
+    if (top > highest)
+        top = highest;
+    if (info->whole)
+        return(floor(bottom + 0.5));
+    if (stat->bins[k] <= 0.0)
+        place = top;
+    else place = bottom + (top - bottom) * (target - cumulative) / stat->bins[k];
+    if (place < bottom)
+        place = bottom;
+    if (!info->log_scale)
+        return(place);
+    if ((k == 0) && (stat->moments.min <= 0.0))
+        return(stat->moments.min);
+    return(pow(10.0, place));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add a value to statistic number 'which' of a group.                    */
+/*--------------------------------------------------------------------------*/
+void add_value(census_group *group, int which, double value, double weight)
+{
+    census_info *info = &census_table[which];
+    census_stat *stat = &group->stats[which];
+    double place;
+    int bin;
+
+    add_moment(&stat->moments, value, weight);
+    place = census_place(info, value);
+    if (place < info->low)
+        bin = 0;
+    else if (place >= info->high)
+        bin = CENSUS_BINS + 1;
+    else bin = 1 + (int)((place - info->low) / (info->high - info->low) * CENSUS_BINS);
+    stat->bins[bin] += weight;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Find the census group called 'name', starting a new one if need be.    */
+/*   The first group, "all", takes every system.                            */
+/*--------------------------------------------------------------------------*/
+census_group *find_group(char *name)
+{
+    census_group *group;
+    int i;
+
+    for (i = 0; i < census_group_count; i++) {
+        if (strcmp(census_groups[i].name, name) == 0)
+            return(&census_groups[i]);
+    }
+    if (census_group_count == MAX_CENSUS_GROUPS) {
+        fprintf(stderr, "ERROR: too many kinds of star in the census\n");
+        exit(1);
+    }
+    group = &census_groups[census_group_count++];
+    memset(group, 0, sizeof(census_group));
+    strncpy(group->name, name, CLASSIFICATION_SIZE - 1);
+    return(group);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Name the group a star belongs in: its spectral and luminosity class,   */
+/*   without the subclass (so "G2 V" is in "G V").                          */
+/*--------------------------------------------------------------------------*/
+char *star_group(star_pointer star)
+{
+    static char name[CLASSIFICATION_SIZE];
+    char *classes;
+
+    name[0] = star->star_type[0];
+    name[1] = '\0';
+    if ((classes = strchr(star->star_type, ' ')) != NULL)
+        strcat(name, classes);
+    return(name);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Pass each value the system in 'sys' gives to the statistics of a       */
+/*   census to 'note', with the number of the statistic.  Values that were  */
+/*   never worked out (moons not built, or fields not asked for) are left   */
+/*   out.                                                                   */
+/*--------------------------------------------------------------------------*/
+void measure_system(void (*note)(int, double))
+{
+    planet_pointer planet, moon;
+    long planets, moons;
+
+    planets = 0;
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        if (planet->mass_type == STAR)
+            continue;
+        planets++;
+        moons = 0;
+        for (moon = planet->first_moon; moon != NULL; moon = moon->next_planet)
+            moons++;
+        (*note)(CENSUS_GAS_GIANTS, (planet->mass_type == GAS_GIANT) ? 1.0 : 0.0);
+        (*note)(CENSUS_MASS, planet->mass * SUN_MASS_IN_EARTH_MASSES);
+        (*note)(CENSUS_A, planet->a);
+        (*note)(CENSUS_E, planet->e);
+        if (planet->moons_built)
+            (*note)(CENSUS_MOONS, (double)moons);
+        if (planet->mass_type == GAS_GIANT)
+            continue;
+        if (field_needed(FIELD_GREENHOUSE))
+            (*note)(CENSUS_GREENHOUSE, planet->greenhouse_effect ? 1.0 : 0.0);
+        if (field_needed(FIELD_SURF_TEMP))
+            (*note)(CENSUS_SURF_TEMP, planet->surf_temp);
+    }
+    (*note)(CENSUS_PLANETS, (double)planets);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Count the system in 'sys' in the census, under "all" and under the     */
+/*   group of its primary.                                                  */
+/*--------------------------------------------------------------------------*/
+void count_value(int which, double value)
+{
+    add_value(counted_groups[0], which, value, system_weight);
+    add_value(counted_groups[1], which, value, system_weight);
+}
+
+void census_system(void)
+{
+    counted_groups[0] = find_group("all");
+    counted_groups[1] = find_group(star_group(sys.primary_star));
+    counted_groups[0]->systems++;
+    counted_groups[1]->systems++;
+    measure_system(count_value);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   For putting the groups in order of name, with "all" first.             */
+/*--------------------------------------------------------------------------*/
+int compare_groups(const void *a, const void *b)
+{
+    char *first = ((census_group *)a)->name;
+    char *second = ((census_group *)b)->name;
+
+    if (strcmp(first, second) == 0)
+        return(0);
+    if (strcmp(first, "all") == 0)
+        return(-1);
+    if (strcmp(second, "all") == 0)
+        return(1);
+    return(strcmp(first, second));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the census, as described above, to be read back by           */
+/*   'read_census'.                                                         */
+/*--------------------------------------------------------------------------*/
+void write_census(FILE *fp)
+{
+    census_group *group;
+    census_stat *stat;
+    int i, j, k;
+
+    qsort(census_groups, (size_t)census_group_count, sizeof(census_group),
+          compare_groups);
+    for (i = 0; i < census_group_count; i++) {
+        group = &census_groups[i];
+        fprintf(fp, "group %ld %s\n", group->systems, group->name);
+        for (j = 0; j < CENSUS_STATS; j++) {
+            stat = &group->stats[j];
+            if (stat->moments.count == 0)
+                continue;
+            fprintf(fp, "stat %s %ld %.17g %.17g %.17g %.17g %.17g %.17g\n",
+                    census_table[j].name, stat->moments.count, stat->moments.mean,
+                    stat->moments.m2, stat->moments.min, stat->moments.max,
+                    stat->moments.weight, stat->moments.weight2);
+            fprintf(fp, "bins %s", census_table[j].name);
+            for (k = 0; k < CENSUS_BINS + 2; k++)
+                fprintf(fp, " %.17g", stat->bins[k]);
+            fprintf(fp, "\n");
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Find the statistic called 'name', returning -1 if there isn't one.     */
+/*--------------------------------------------------------------------------*/
+int find_statistic(char *name)
+{
+    int i;
+
+    for (i = 0; i < CENSUS_STATS; i++) {
+        if (strcmp(census_table[i].name, name) == 0)
+            return(i);
+    }
+    return(-1);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read a census written by 'write_census' and merge it into this one.    */
+/*   FALSE is returned if it makes no sense.                                */
+/*--------------------------------------------------------------------------*/
+int read_census(FILE *fp)
+{
+    census_group *group = NULL;
+    census_stat *stat;
+    running_stat moments;
+    char word[16], name[CLASSIFICATION_SIZE], stat_name[16], rest[64];
+    double weight;
+    long systems;
+    int which, k;
+
+    while (fscanf(fp, "%15s", word) == 1) {
+        if (strcmp(word, "group") == 0) {
+            if ((fscanf(fp, "%ld %1[A-Za-z]", &systems, name) != 2)
+                || (fgets(name + 1, CLASSIFICATION_SIZE - 1, fp) == NULL))
+                return(FALSE);
+            name[strcspn(name, "\n")] = '\0';
+            group = find_group(name);
+            group->systems += systems;
+            continue;
+        }
+        if ((group == NULL) || (fscanf(fp, "%15s", stat_name) != 1)
+            || ((which = find_statistic(stat_name)) < 0))
+            return(FALSE);
+        stat = &group->stats[which];
+        if (strcmp(word, "stat") == 0) {
+            if ((fscanf(fp, "%ld %lf %lf %lf %lf", &moments.count, &moments.mean,
+                        &moments.m2, &moments.min, &moments.max) != 5)
+                || (fgets(rest, sizeof(rest), fp) == NULL))
+                return(FALSE);
+            /*
+             *  Censuses saved before systems were weighted have no weight:
+             */
+            if (sscanf(rest, "%lf %lf", &moments.weight, &moments.weight2) != 2) {
+                moments.weight = (double)moments.count;
+                moments.weight2 = (double)moments.count;
+            }
+            merge_moments(&stat->moments, &moments);
+        }
+        else if (strcmp(word, "bins") == 0) {
+            for (k = 0; k < CENSUS_BINS + 2; k++) {
+                if (fscanf(fp, "%lf", &weight) != 1)
+                    return(FALSE);
+                stat->bins[k] += weight;
+            }
+        }
+        else return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note a saved census, named with '-I', to be added to this run's.       */
+/*--------------------------------------------------------------------------*/
+int add_census_input(char *name)
+{
+    if (census_input_count == MAX_CENSUS_INPUTS)
+        return(FALSE);
+    census_inputs[census_input_count++] = name;
+    return(TRUE);
+}
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   Merge a census sent back by a worker process into this one.            */
+/*--------------------------------------------------------------------------*/
+void merge_census_text(char *text, long length)
+{
+    FILE *fp;
+
+    if (((fp = fmemopen(text, (size_t)length, "r")) == NULL) || !read_census(fp)) {
+        fprintf(stderr, "ERROR: a worker sent back a bad census\n");
+        exit(1);
+    }
+    fclose(fp);
+}
+
+#endif /* MULTIPROC */
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the census as a table, a group of systems at a time.         */
+/*--------------------------------------------------------------------------*/
+void report_census(FILE *fp)
+{
+    census_group *group;
+    census_stat *stat;
+    double deviation, weight;
+    int i, j;
+
+    qsort(census_groups, (size_t)census_group_count, sizeof(census_group),
+          compare_groups);
+    fprintf(fp, "                         CENSUS\n\n");
+    for (i = 0; i < census_group_count; i++) {
+        group = &census_groups[i];
+        if (strcmp(group->name, "all") == 0)
+            fprintf(fp, "All systems (%ld", group->systems);
+        else fprintf(fp, "Primary %s (%ld systems", group->name, group->systems);
+        weight = group->stats[CENSUS_PLANETS].moments.weight;
+        if (weight != (double)group->stats[CENSUS_PLANETS].moments.count)
+            fprintf(fp, ", weight %.6g", weight);
+        fprintf(fp, ")\n");
+        fprintf(fp, "   %-11s %9s %10s %10s %10s %10s %10s %10s %10s\n", "",
+                "count", "mean", "std dev", "min", "10%", "median", "90%", "max");
+        for (j = 0; j < CENSUS_STATS; j++) {
+            stat = &group->stats[j];
+            if (stat->moments.count == 0)
+                continue;
+            deviation = (stat->moments.max > stat->moments.min)
+                        ? sqrt(stat->moments.m2 / (stat->moments.count - 1)
+                               * (stat->moments.count / stat->moments.weight)) : 0.0;
+            fprintf(fp, "   %-11s %9ld %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g\n",
+                    census_table[j].name, stat->moments.count, stat->moments.mean,
+                    deviation, stat->moments.min,
+                    census_quantile(stat, &census_table[j], 0.1),
+                    census_quantile(stat, &census_table[j], 0.5),
+                    census_quantile(stat, &census_table[j], 0.9),
+                    stat->moments.max);
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Once the batch is over, add in the saved censuses named with '-I',     */
+/*   save the whole census if '-a' named a file, and write out the table    */
+/*   on 'fp'.                                                               */
+/*--------------------------------------------------------------------------*/
+void finish_census(FILE *fp)
+{
+    FILE *saved;
+    int i;
+
+    for (i = 0; i < census_input_count; i++) {
+        if ((saved = fopen(census_inputs[i], "r")) == NULL) {
+            perror(census_inputs[i]);
+            exit(1);
+        }
+        if (!read_census(saved)) {
+            fprintf(stderr, "ERROR: <%s> isn't a census\n", census_inputs[i]);
+            exit(1);
+        }
+        fclose(saved);
+    }
+    if (*flag_census != '\0') {
+        if ((saved = fopen(flag_census, "w")) == NULL) {
+            perror(flag_census);
+            exit(1);
+        }
+        write_census(saved);
+        fclose(saved);
+    }
+    report_census(fp);
+}
@@ -29,3 +29,14 @@
 
 /*#define BSD*/
 
+
+/*
+ * For machines that provide fork(), pipe(), poll() and open_memstream().
+ * Batch runs (-n) are then built by separate worker processes (-j) while
+ * the original process does all the writing.  Without this, a batch is
+ * simply generated one system after another.
+ */
+
+#if defined(unix) || defined(__unix__) || defined(__APPLE__)
+#define MULTIPROC
+#endif
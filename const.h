@@ -67,6 +67,10 @@
 #define GRAV_CONSTANT		(6.672E-8)	/* units of dyne cm2/gram2  */
 #define GREENHOUSE_EFFECT_CONST	(0.93)		/* affects inner radius..   */
 #define MOLAR_GAS_CONST		(8314.41)	/* units: g*m2/(sec2*K*mol) */
+/*
+ *  The usual values of the physical parameters that can be changed with
+ *  '-p' (see params.c):
+ */
 #define K			(50.0)		/* K = gas/dust ratio       */
 #define B			(1.2E-5)	/* Used in Crit_mass calc   */
 #define DUST_DENSITY_COEFF	(6.0E-3)	/* A in Dole's paper        */
@@ -76,6 +80,39 @@
 #define TRIVIAL_MASS            (1.0E-14)       /* Units of solar masses    */
 #define TEMP_ITERATION_LIMIT	(101)		/* Limit on temp iterations */
 #define CLASSIFICATION_SIZE	(10)		/* Size of star_type field  */
+#define OUTPUT_BUFFER_SIZE	(1048576)	/* Bytes of batch output buffered */
+#define TASK_LINE_SIZE		(512)		/* Longest batch task line  */
+#define WORKER_QUEUE_DEPTH	(4)		/* Systems queued per worker */
+#define COMPRESS_BLOCK_SIZE	(1048576)	/* Bytes per compressed block */
+#define SERVER_LINE_SIZE	(4096)		/* Longest server request   */
+#define SERVER_BACKLOG		(64)		/* Connections left waiting */
+#define CACHE_TABLE_SIZE	(4099)		/* Hash buckets in the cache */
+#define CACHE_NAME_SIZE		(1024)		/* Longest cache file name  */
+#define MAX_SWEEP_AXES		(9)		/* Parameters in a sweep    */
+#define SWEEP_TASK_START	(40)		/* Task line before a point */
+#define SWEEP_VALUE_SIZE	(16)		/* "=value " of a point     */
+#define MAX_MOON_LIST		(64)		/* Planets listed with -M   */
+#define SNAPSHOT_LINE_SIZE	(1024)		/* Longest snapshot line    */
+#define SNAPSHOT_SIZE		(8192)		/* Longest snapshot         */
+#define MAX_SEARCH_TERMS	(16)		/* Conditions given with -Q */
+#define MAX_CENSUS_GROUPS	(48)		/* Kinds of primary counted */
+#define MAX_CENSUS_INPUTS	(64)		/* Censuses given with -I   */
+#define CENSUS_BINS		(200)		/* Bins in each histogram   */
+#define MAX_SAMPLE_STRATA	(512)		/* Kinds of system sampled  */
+#define STRATUM_NAME_SIZE	(32)		/* Longest kind of system   */
+#define MAX_CONVERGE_TARGETS	(8)		/* Targets given with -c    */
+#define CONVERGE_NAME_SIZE	(16)		/* Longest statistic name   */
+#define CONVERGE_INTERVAL	(100)		/* Systems between checks   */
+#define CONVERGE_MIN_COUNT	(30)		/* Fewest values to judge by */
+#define CONVERGE_Z		(1.96)		/* For a 95% interval       */
+#define MAX_STAR_WEIGHTS	(16)		/* Weights given with -W    */
+#define LUMINOSITY_CLASSES	(4)		/* Main sequence, ...       */
+#define SPECTRAL_LINES		(15)		/* Lines of each stardata array */
+#define STAR_CELLS	(LUMINOSITY_CLASSES * SPECTRAL_LINES * SPECTRAL_LINES)	/* Pieces, -W */
+#define MAX_SHARD_INPUTS	(256)		/* Shards given with -J     */
+#define JOURNAL_SECONDS		(10)		/* Between journal entries  */
+#define TIMING_SUB_BINS		(16)		/* Timing bins per doubling */
+#define TIMING_BINS		(48 * TIMING_SUB_BINS)	/* ... from 1 ns up */
 
 
 /*  Now for a few molecular weights (used for RMS velocity calcs):     */
@@ -121,6 +158,130 @@
 #define WHITE_DWARF		3
 #define MAIN_SEQUENCE 	4
 
+/*
+ *  The stages of generating a system a step at a time (see step.c), and
+ *  what 'generate_step' returns:
+ */
+#define STAGE_STARS		0
+#define STAGE_ACCRETION		1
+#define STAGE_PLANETS		2
+#define STAGE_DONE		3
+
+#define GEN_IN_PROGRESS		0
+#define GEN_DONE		1
+
+/*
+ *  The work budgets (the -b flags) a system can run out of:
+ */
+#define BUDGET_INJECTIONS	1
+#define BUDGET_SWEEPS		2
+#define BUDGET_TIME		4
+
+/*
+ *  The streams of random numbers each system draws on (see utils.c):
+ */
+#define STREAM_STARS		1
+#define STREAM_ACCRETION	2
+#define STREAM_ENVIRONMENT	3
+#define STREAM_MOONS		4
+#define STREAM_SWEEP		5
+
+/*
+ *  The characteristics of a planet that can be asked for with -F (see
+ *  fields.c):
+ */
+#define FIELD_RADIUS		0x00001L
+#define FIELD_DENSITY		0x00002L
+#define FIELD_ORB_PERIOD	0x00004L
+#define FIELD_DAY		0x00008L
+#define FIELD_AXIAL_TILT	0x00010L
+#define FIELD_ESC_VELOCITY	0x00020L
+#define FIELD_SURF_ACCEL	0x00040L
+#define FIELD_RMS_VELOCITY	0x00080L
+#define FIELD_MOLEC_WEIGHT	0x00100L
+#define FIELD_SURF_GRAV		0x00200L
+#define FIELD_GREENHOUSE	0x00400L
+#define FIELD_VOLATILES		0x00800L
+#define FIELD_SURF_PRESSURE	0x01000L
+#define FIELD_BOIL_POINT	0x02000L
+#define FIELD_SURF_TEMP		0x04000L
+#define FIELD_ALBEDO		0x08000L
+#define FIELD_HYDROSPHERE	0x10000L
+#define FIELD_CLOUD_COVER	0x20000L
+#define FIELD_ICE_COVER		0x40000L
+#define FIELD_ALL		0x7FFFFL
+
+/*
+ *  The kinds of parameter sweep (the -S flag):
+ */
+#define SWEEP_NONE		0
+#define SWEEP_GRID		1
+#define SWEEP_LHS		2
+
+/*
+ *  The kinds of condition a search (the -Q flag) can make, and how far a
+ *  system got before it failed one (see search.c):
+ */
+#define TERM_SPECTRAL		1
+#define TERM_LUMINOSITY		2
+#define TERM_STARS		3
+#define TERM_STAR_MASS		4
+#define TERM_A			5
+#define TERM_E			6
+#define TERM_MASS		7
+#define TERM_TYPE		8
+#define TERM_FIELD		9
+
+#define REJECTED_NONE		0
+#define REJECTED_STARS		1
+#define REJECTED_ORBITS		2
+#define REJECTED_ENVIRONMENT	3
+
+/*
+ *  The statistics kept in a census (the -a flag, see census.c):
+ */
+#define CENSUS_PLANETS		0
+#define CENSUS_GAS_GIANTS	1
+#define CENSUS_MASS		2
+#define CENSUS_A		3
+#define CENSUS_E		4
+#define CENSUS_GREENHOUSE	5
+#define CENSUS_SURF_TEMP	6
+#define CENSUS_MOONS		7
+#define CENSUS_STATS		8
+
+/*
+ *  How the systems of a batch can be split up before they are sampled
+ *  (the -r flag, see sample.c):
+ */
+#define SAMPLE_BY_STAR		1
+#define SAMPLE_BY_PLANETS	2
+
+/*
+ *  The records that aren't systems, in what a worker process sends back
+ *  and in the output of a shard (see batch.c and shard.c):
+ */
+#define RECORD_CENSUS		(-1L)
+#define RECORD_RANKING		(-2L)
+#define RECORD_SAMPLE		(-3L)
+#define RECORD_SHARD		(-4L)	/* which shard, heading its output */
+#define RECORD_END		(-5L)	/* the end of a shard's systems    */
+#define RECORD_TIMING		(-6L)
+
+/*
+ *  The stages each system's time is split between (the -i flag, see
+ *  timing.c):
+ */
+#define TIMING_STARS		0
+#define TIMING_PLANET_LIST	1
+#define TIMING_ACCRETION	2
+#define TIMING_CHECK		3
+#define TIMING_MOONS		4
+#define TIMING_ENVIRONMENT	5
+#define TIMING_DISPLAY		6
+#define TIMING_SYSTEM		7	/* the whole of it */
+#define TIMING_STAGES		8
+
 /*
  *  The following defines are used in the kothari_radius function in
  *  file enviro.c.
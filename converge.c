@@ -0,0 +1,205 @@
+/*----------------------------------------------------------------------*/
+/*                              converge.c                              */
+/*                                                                      */
+/*  Batches that stop once the statistics they are run for are known    */
+/*  well enough (the -c flag).  Each target names a statistic of the    */
+/*  census (see census.c), for all systems or for one kind of primary,  */
+/*  and how wide the 95% confidence interval of its mean may be:        */
+/*                                                                      */
+/*      -cplanets=0.5,gas_giants@G V=0.02                               */
+/*                                                                      */
+/*  asks for the mean number of planets to within 0.5 and the fraction  */
+/*  of the planets of G dwarfs that are gas giants to within 0.02.      */
+/*  Each system's values are passed back with it, and every hundred     */
+/*  systems the batch checks whether every target has come in under     */
+/*  its width (with at least thirty values behind it).  If so no more   */
+/*  systems are handed out, and the batch ends there.  -n gives the     */
+/*  most systems to make if they never do.                              */
+/*                                                                      */
+/*  The values are added up in the order of the batch, so the batch     */
+/*  stops at the same system however many processes are making it.      */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <math.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern census_info census_table[];
+extern int search_rejected;
+extern double system_weight;
+
+/*
+ *  The targets, the values the system just made gives each of them,
+ *  and how far the batch has got:
+ */
+converge_target targets[MAX_CONVERGE_TARGETS];
+int target_count = 0;
+running_stat system_targets[MAX_CONVERGE_TARGETS];
+char *measured_group;                   /* that of the system being made */
+long converge_systems = 0;
+long converged_at = 0;                  /* systems it took, once it has  */
+
+/*--------------------------------------------------------------------------*/
+/*   Decode the targets given with '-c'.  FALSE is returned if they can't   */
+/*   be understood.                                                         */
+/*--------------------------------------------------------------------------*/
+int read_targets(char *spec)
+{
+    converge_target *target;
+    char name[CONVERGE_NAME_SIZE];
+    char *c, *end;
+    int length;
+
+    for (c = spec; *c != '\0'; c = end) {
+        if (target_count == MAX_CONVERGE_TARGETS) {
+            fprintf(stderr, "ERROR: too many targets given with -c\n");
+            return(FALSE);
+        }
+        target = &targets[target_count++];
+        memset(target, 0, sizeof(converge_target));
+        length = (int)strcspn(c, "@=,");
+        if (length >= CONVERGE_NAME_SIZE)
+            length = CONVERGE_NAME_SIZE - 1;
+        strncpy(name, c, (size_t)length);
+        name[length] = '\0';
+        if ((target->stat = find_statistic(name)) < 0) {
+            fprintf(stderr, "ERROR: no statistic called <%s>\n", name);
+            return(FALSE);
+        }
+        c += strcspn(c, "@=,");
+        strcpy(target->group, "all");
+        if (*c == '@') {
+            length = (int)strcspn(++c, "=,");
+            if ((length == 0) || (length >= CLASSIFICATION_SIZE)) {
+                fprintf(stderr, "ERROR: bad kind of star in <%s>\n", spec);
+                return(FALSE);
+            }
+            strncpy(target->group, c, (size_t)length);
+            target->group[length] = '\0';
+            c += length;
+        }
+        if (*c != '=') {
+            fprintf(stderr, "ERROR: no width given for <%s> in <%s>\n", name, spec);
+            return(FALSE);
+        }
+        target->width = strtod(++c, &end);
+        if ((end == c) || (target->width <= 0.0) || ((*end != ',') && (*end != '\0'))) {
+            fprintf(stderr, "ERROR: bad width in <%s>\n", spec);
+            return(FALSE);
+        }
+        if (*end == ',')
+            end++;
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add one of the values of the system being measured to each target it   */
+/*   counts towards.                                                        */
+/*--------------------------------------------------------------------------*/
+void target_value(int which, double value)
+{
+    int i;
+
+    for (i = 0; i < target_count; i++) {
+        if ((targets[i].stat == which)
+            && ((strcmp(targets[i].group, "all") == 0)
+                || (strcmp(targets[i].group, measured_group) == 0)))
+            add_moment(&system_targets[i], value, system_weight);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Work out the values the system in 'sys' gives each target, ready to    */
+/*   be passed back with it.  A system a search rejected gives none.        */
+/*--------------------------------------------------------------------------*/
+void measure_targets(void)
+{
+    memset(system_targets, 0, sizeof(system_targets));
+    if (search_rejected != REJECTED_NONE)
+        return;
+    measured_group = star_group(sys.primary_star);
+    measure_system(target_value);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The width of the 95% confidence interval of the mean of a target so    */
+/*   far, or -1 if there are too few values to tell.  Where systems are     */
+/*   weighted (-W) the values are worth fewer than their count: the mean    */
+/*   is only as sure as one of (sum of weights)^2 / (sum of squares of      */
+/*   weights) values with equal weights.                                    */
+/*--------------------------------------------------------------------------*/
+double interval_width(converge_target *target)
+{
+    running_stat *moments = &target->moments;
+    double effective, variance;
+
+    if ((moments->count < 2) || (moments->weight2 <= 0.0))
+        return(-1.0);
+    effective = moments->weight * moments->weight / moments->weight2;
+    if (effective <= 1.0)
+        return(-1.0);
+    variance = moments->m2 / (moments->weight - moments->weight2 / moments->weight);
+    return(2.0 * CONVERGE_Z * sqrt(variance / effective));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add the values of the next system of the batch to the targets.  TRUE   */
+/*   is returned once all of them have come in under their widths, and the  */
+/*   batch should stop.                                                     */
+/*--------------------------------------------------------------------------*/
+int add_targets(running_stat *moments)
+{
+    double width;
+    int i;
+
+    converge_systems++;
+    for (i = 0; i < target_count; i++)
+        merge_moments(&targets[i].moments, &moments[i]);
+    if (converge_systems % CONVERGE_INTERVAL != 0)
+        return(FALSE);
+    for (i = 0; i < target_count; i++) {
+        width = interval_width(&targets[i]);
+        if ((targets[i].moments.count < CONVERGE_MIN_COUNT)
+            || (width < 0.0) || (width > targets[i].width))
+            return(FALSE);
+    }
+    converged_at = converge_systems;
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Say how many systems the batch took to converge (or that it didn't),   */
+/*   and how well each target is known.                                     */
+/*--------------------------------------------------------------------------*/
+void report_convergence(void)
+{
+    converge_target *target;
+    double width;
+    int i;
+
+    if (target_count == 0)
+        return;
+    if (converged_at > 0)
+        fprintf(stderr, "Converged after %ld systems\n", converged_at);
+    else fprintf(stderr, "Not converged after %ld systems\n", converge_systems);
+    for (i = 0; i < target_count; i++) {
+        target = &targets[i];
+        width = interval_width(target);
+        fprintf(stderr, "    %-10s %-6s %10ld values, mean %.4f",
+                census_table[target->stat].name, target->group,
+                target->moments.count, target->moments.mean);
+        if (width < 0.0)
+            fprintf(stderr, " (too few values to tell)\n");
+        else fprintf(stderr, " +/- %.4f (%.4f wanted)\n",
+                     width / 2.0, target->width / 2.0);
+    }
+}
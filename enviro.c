@@ -19,6 +19,7 @@
 extern star_system sys;
 
 extern int resonance;
+extern physics_params physics;
 
 
 /*--------------------------------------------------------------------------*/
@@ -285,7 +286,7 @@ double molecule_limit(double mass, double equat_radius)
     double esc_velocity;
 
     esc_velocity = escape_vel(mass,equat_radius);
-    return((3.0 * power(GAS_RETENTION_THRESHOLD * CM_PER_METER, 2.0)
+    return((3.0 * power(physics.gas_retention_threshold * CM_PER_METER, 2.0)
         * MOLAR_GAS_CONST * EARTH_EXOSPHERE_TEMP)
         / power(esc_velocity,2.0));
 }
@@ -340,7 +341,7 @@ double vol_inventory(double mass, double esc_velocity, double rms_velocity, doub
     double velocity_ratio, proportion_const, temp1, temp2, earth_units;
 
     velocity_ratio = esc_velocity / rms_velocity;
-    if (velocity_ratio >= GAS_RETENTION_THRESHOLD) {
+    if (velocity_ratio >= physics.gas_retention_threshold) {
         switch (zone) {
         case 1:
             proportion_const = 100000.0;
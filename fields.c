@@ -0,0 +1,136 @@
+/*----------------------------------------------------------------------*/
+/*                               fields.c                               */
+/*                                                                      */
+/*  Choosing which of the planets' characteristics are worked out and   */
+/*  shown (the -F flag).  A run that only wants, say, the surface       */
+/*  temperature and hydrosphere of each planet can ask for just those:  */
+/*                                                                      */
+/*      -Fsurf_temp,hydrosphere                                         */
+/*                                                                      */
+/*  Each planet then gets only those fields and the ones they depend    */
+/*  on (the temperature needs the pressure, which needs the volatile    */
+/*  gases, which need the escape velocity, and so on).  The orbit and   */
+/*  mass of each planet are always given.                               */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+/*
+ *  The fields that can be asked for, and those each needs worked out
+ *  first.  The surface temperature loop gives the albedo, hydrosphere,
+ *  cloud and ice cover along with the temperature.
+ */
+field_info field_table[] = {
+	{"radius",                 FIELD_RADIUS,        0L},
+	{"density",                FIELD_DENSITY,       0L},
+	{"orb_period",             FIELD_ORB_PERIOD,    0L},
+	{"day",                    FIELD_DAY,           FIELD_ORB_PERIOD},
+	{"axial_tilt",             FIELD_AXIAL_TILT,    0L},
+	{"esc_velocity",           FIELD_ESC_VELOCITY,  0L},
+	{"surf_accel",             FIELD_SURF_ACCEL,    0L},
+	{"rms_velocity",           FIELD_RMS_VELOCITY,  0L},
+	{"molec_weight",           FIELD_MOLEC_WEIGHT,  0L},
+	{"surf_grav",              FIELD_SURF_GRAV,     FIELD_SURF_ACCEL},
+	{"greenhouse_effect",      FIELD_GREENHOUSE,    0L},
+	{"volatile_gas_inventory", FIELD_VOLATILES,     FIELD_ESC_VELOCITY
+	                                                | FIELD_RMS_VELOCITY
+	                                                | FIELD_GREENHOUSE},
+	{"surf_pressure",          FIELD_SURF_PRESSURE, FIELD_VOLATILES
+	                                                | FIELD_SURF_GRAV
+	                                                | FIELD_GREENHOUSE},
+	{"boil_point",             FIELD_BOIL_POINT,    FIELD_SURF_PRESSURE},
+	{"surf_temp",              FIELD_SURF_TEMP,     FIELD_VOLATILES
+	                                                | FIELD_MOLEC_WEIGHT
+	                                                | FIELD_SURF_PRESSURE
+	                                                | FIELD_BOIL_POINT},
+	{"albedo",                 FIELD_ALBEDO,        FIELD_SURF_TEMP},
+	{"hydrosphere",            FIELD_HYDROSPHERE,   FIELD_SURF_TEMP},
+	{"cloud_cover",            FIELD_CLOUD_COVER,   FIELD_SURF_TEMP},
+	{"ice_cover",              FIELD_ICE_COVER,     FIELD_SURF_TEMP},
+	{NULL,                     0L,                  0L}
+};
+
+/*
+ *  The fields shown, those wanted for other reasons (such as a search),
+ *  and the fields worked out (those shown or wanted and all they depend
+ *  on):
+ */
+long shown_fields = FIELD_ALL;
+long wanted_fields = 0L;
+long planet_fields = FIELD_ALL;
+
+/*--------------------------------------------------------------------------*/
+/*   Add to 'fields' every field that they depend on, however indirectly.   */
+/*--------------------------------------------------------------------------*/
+long field_closure(long fields)
+{
+    field_info *field;
+    long before;
+
+    do {
+        before = fields;
+        for (field = field_table; field->name != NULL; field++) {
+            if (fields & field->bit)
+                fields |= field->needs;
+        }
+    } while (fields != before);
+    return(fields);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the fields given with '-F', separated by commas or spaces.  Any   */
+/*   others wanted are worked out as well.  FALSE is returned (after        */
+/*   saying why) if any is unknown.  Note that 'spec' is broken up in the   */
+/*   process.                                                               */
+/*--------------------------------------------------------------------------*/
+int read_fields(char *spec)
+{
+    field_info *field;
+    char *word;
+
+    shown_fields = 0L;
+    for (word = strtok(spec, " ,"); word != NULL; word = strtok(NULL, " ,")) {
+        for (field = field_table; field->name != NULL; field++) {
+            if (strcmp(field->name, word) == 0)
+                break;
+        }
+        if (field->name == NULL) {
+            fprintf(stderr, "ERROR: unknown field <%s>\n", word);
+            return(FALSE);
+        }
+        shown_fields |= field->bit;
+    }
+    planet_fields = field_closure(shown_fields | wanted_fields);
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Have 'fields' worked out, whether or not they are shown (a search      */
+/*   with -Q needs the fields it tests, for instance).                      */
+/*--------------------------------------------------------------------------*/
+void want_fields(long fields)
+{
+    wanted_fields |= fields;
+    planet_fields = field_closure(planet_fields | fields);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if any of 'fields' is to be worked out, or shown.                 */
+/*--------------------------------------------------------------------------*/
+int field_needed(long fields)
+{
+    return((planet_fields & fields) != 0);
+}
+
+int field_shown(long fields)
+{
+    return((shown_fields & fields) != 0);
+}
@@ -0,0 +1,211 @@
+/*----------------------------------------------------------------------*/
+/*                              journal.c                               */
+/*                                                                      */
+/*  Carrying on a long batch after it has been stopped or has died      */
+/*  (the -l and -R flags).  With '-l<file>' the batch keeps a journal   */
+/*  in <file> of how far it has got: its seed, then every so often a    */
+/*  line giving how many systems have been written out and how many     */
+/*  bytes of output they came to.  Each line is only added once the     */
+/*  output before it is safely on disk, and is itself flushed to disk,  */
+/*  so whatever happens the last whole line is a point the output can   */
+/*  be cut back to.  '-R' does just that and carries on from there:     */
+/*                                                                      */
+/*      starform -s42 -n1000000 -lcat.log > cat                         */
+/*      starform -s42 -n1000000 -lcat.log -R >> cat                     */
+/*                                                                      */
+/*  The output must be appended to ('>>'), or it would be emptied       */
+/*  before starform could look at it.  An interrupt or 'kill' (SIGINT   */
+/*  or SIGTERM) stops the batch cleanly: the systems written so far     */
+/*  are flushed and noted in the journal before it exits.               */
+/*                                                                      */
+/*  Only the systems themselves are kept track of, so a census,         */
+/*  ranking, sample or run to convergence can't be carried on.          */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <time.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <signal.h>
+#include    <unistd.h>
+#include    <sys/stat.h>
+#include    <sys/wait.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+#ifdef MULTIPROC
+
+extern unsigned flag_seed;
+extern char *flag_journal;
+extern int flag_resume;
+extern long output_bytes;
+
+/*
+ *  The journal, where a resumed batch carries on from, and the signal
+ *  that stopped the batch, if one has:
+ */
+FILE *journal = NULL;
+time_t journal_time = 0;
+long resume_place = 0;
+long resume_bytes = 0;
+volatile sig_atomic_t stop_signal = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Note that the batch has been asked to stop.  The batch itself stops    */
+/*   once it is safe to.                                                    */
+/*--------------------------------------------------------------------------*/
+void note_stop(int signal_number)
+{
+    stop_signal = signal_number;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   With '-R', read back the journal of the batch being carried on: its    */
+/*   seed, which the batch is made with again, and the last point it got    */
+/*   to.  The output is cut back to that point.                             */
+/*--------------------------------------------------------------------------*/
+void open_journal(void)
+{
+    char line[SNAPSHOT_LINE_SIZE];
+    struct stat status;
+    unsigned seed;
+    long place, bytes;
+    FILE *fp;
+
+    if (!flag_resume)
+        return;
+    if ((fp = fopen(flag_journal, "r")) == NULL) {
+        perror(flag_journal);
+        exit(1);
+    }
+    seed = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strchr(line, '\n') == NULL)
+            break;              /* cut short as it was being written */
+        if (strcmp(line, "finished\n") == 0) {
+            fprintf(stderr, "ERROR: the batch in <%s> is already finished\n", flag_journal);
+            exit(1);
+        }
+        if (sscanf(line, "systems %ld bytes %ld", &place, &bytes) == 2) {
+            resume_place = place;
+            resume_bytes = bytes;
+        }
+        else sscanf(line, "seed %u", &seed);
+    }
+    fclose(fp);
+    if ((seed == 0) || (flag_seed && (flag_seed != seed))) {
+        fprintf(stderr, "ERROR: <%s> isn't the journal of this batch\n", flag_journal);
+        exit(1);
+    }
+    flag_seed = seed;
+    if ((fstat(STDOUT_FILENO, &status) < 0) || !S_ISREG(status.st_mode)
+        || ((long)status.st_size < resume_bytes)) {
+        fprintf(stderr, "ERROR: the output of the batch must be appended to (>>)\n");
+        exit(1);
+    }
+    if ((ftruncate(STDOUT_FILENO, (off_t)resume_bytes) < 0)
+        || (lseek(STDOUT_FILENO, (off_t)resume_bytes, SEEK_SET) < 0)) {
+        perror("cutting back the output");
+        exit(1);
+    }
+    output_bytes = resume_bytes;
+    fprintf(stderr, "Carrying on after %ld systems\n", resume_place);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the journal for a batch made with the given seed, starting   */
+/*   it afresh (a resumed batch's journal is written out again, without     */
+/*   anything after the point it carries on from), and catch the signals    */
+/*   that stop it.  The old journal is only replaced once the new one is    */
+/*   safely on disk.                                                        */
+/*--------------------------------------------------------------------------*/
+void start_journal(unsigned seed)
+{
+    char name[CACHE_NAME_SIZE];
+
+    if (strlen(flag_journal) + 5 > sizeof(name)) {
+        fprintf(stderr, "ERROR: the journal's name is too long\n");
+        exit(1);
+    }
+    sprintf(name, "%s.new", flag_journal);
+    if ((journal = fopen(name, "w")) == NULL) {
+        perror(name);
+        exit(1);
+    }
+    fprintf(journal, "Starform journal - V%s\nseed %u\n", VERSION, seed);
+    commit_journal(resume_place);
+    if (rename(name, flag_journal) < 0) {
+        perror(flag_journal);
+        exit(1);
+    }
+    signal(SIGINT, note_stop);
+    signal(SIGTERM, note_stop);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note in the journal that the first 'place' systems of the batch have   */
+/*   been written out, once they are on disk.                               */
+/*--------------------------------------------------------------------------*/
+void commit_journal(long place)
+{
+    long bytes;
+
+    bytes = flush_output();
+    fsync(STDOUT_FILENO);       /* fails harmlessly on a pipe */
+    fprintf(journal, "systems %ld bytes %ld\n", place, bytes);
+    if ((fflush(journal) != 0) || (fsync(fileno(journal)) < 0)) {
+        perror("writing the journal");
+        exit(1);
+    }
+    journal_time = time(NULL);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if it is time the journal was brought up to date.                 */
+/*--------------------------------------------------------------------------*/
+int journal_due(void)
+{
+    return(time(NULL) - journal_time >= JOURNAL_SECONDS);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note in the journal that the batch is over.                            */
+/*--------------------------------------------------------------------------*/
+void finish_journal(long place)
+{
+    commit_journal(place);
+    fprintf(journal, "finished\n");
+    if ((fflush(journal) != 0) || (fsync(fileno(journal)) < 0)) {
+        perror("writing the journal");
+        exit(1);
+    }
+    fclose(journal);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Stop the batch once a signal has asked it to: note the systems         */
+/*   written out so far in the journal, and put an end to the workers.      */
+/*--------------------------------------------------------------------------*/
+void stop_batch(worker_info *workers, int count, long place)
+{
+    int i;
+
+    commit_journal(place);
+    fclose(journal);
+    for (i = 0; i < count; i++) {
+        kill((pid_t)workers[i].pid, SIGKILL);
+        waitpid((pid_t)workers[i].pid, NULL, 0);
+    }
+    fprintf(stderr, "Stopped after %ld systems; carry on with -R\n", place);
+    exit(1);
+}
+
+#endif /* MULTIPROC */
@@ -0,0 +1,191 @@
+/*----------------------------------------------------------------------*/
+/*                                moons.c                               */
+/*                                                                      */
+/*  Accreting the moons of a system's planets in several processes at   */
+/*  once (the -K flag), so that a single large system with moons comes  */
+/*  back sooner.  The moons of each planet are independent of those of  */
+/*  every other, and draw on a stream of random numbers of their own    */
+/*  (see utils.c), so they can be built in any order.  The accretion    */
+/*  routines keep their state in globals, so rather than threads each   */
+/*  share of the planets gets a forked copy of the whole system.  The   */
+/*  moons come back through a pipe and are hung on their planets before */
+/*  any planet is finished, so the system comes out just as it would    */
+/*  with all its moons built one after another.                         */
+/*                                                                      */
+/*  The work budgets (the -b flags) are shared by all of a system's     */
+/*  moons, so a system with a budget always has its moons built in      */
+/*  turn.                                                               */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <unistd.h>
+#include    <sys/wait.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern int flag_moons;
+extern int flag_lazy_moons;
+extern int flag_moon_workers;
+extern long flag_max_injections;
+extern long flag_max_sweeps;
+extern long flag_max_msec;
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   Build the moons of every 'count'th planet of the system, starting      */
+/*   with planet 'first', and send them down 'fd'.  For each planet its     */
+/*   number and how many moons it has are sent, then the moons themselves.  */
+/*--------------------------------------------------------------------------*/
+void send_moons(int fd, long first, long count)
+{
+    planet_pointer planet, moon;
+    long number, header[2];
+
+    number = 0;
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        if (planet->mass_type == STAR)
+            continue;
+        if (number % count == first) {
+            size_planet(planet);
+            planet->moon_seed = stream_start(STREAM_MOONS, number);
+            build_moons(planet);
+            header[0] = number;
+            header[1] = 0;
+            for (moon = planet->first_moon; moon != NULL; moon = moon->next_planet)
+                header[1]++;
+            write_full(fd, (char *)header, (long)sizeof(header));
+            for (moon = planet->first_moon; moon != NULL; moon = moon->next_planet)
+                write_full(fd, (char *)moon, (long)sizeof(planets));
+        }
+        number++;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read back the moons sent by 'send_moons' and hang them on their        */
+/*   planets.  FALSE is returned if they make no sense or stop part way     */
+/*   through a planet's moons; a process that quit between planets is only  */
+/*   found out by its exit status (see share_out_moons).                    */
+/*--------------------------------------------------------------------------*/
+int receive_moons(int fd)
+{
+    planet_pointer planet, moon, *tail;
+    long number, header[2];
+
+    while (read_full(fd, (char *)header, (long)sizeof(header))) {
+        number = 0;
+        for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+            if ((planet->mass_type != STAR) && (number++ == header[0]))
+                break;
+        }
+        if (planet == NULL)
+            return(FALSE);
+        tail = &planet->first_moon;
+        for (; header[1] > 0; header[1]--) {
+            if ((moon = (planets *)malloc(sizeof(planets))) == NULL) {
+                perror("malloc'ing a moon");
+                exit(1);
+            }
+            if (!read_full(fd, (char *)moon, (long)sizeof(planets))) {
+                free(moon);
+                return(FALSE);
+            }
+            moon->first_moon = NULL;
+            moon->next_planet = NULL;
+            moon->star_ptr = NULL;
+            *tail = moon;
+            tail = &moon->next_planet;
+        }
+        planet->moons_built = TRUE;
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Build the moons of all the system's planets, sharing the planets out   */
+/*   among up to '-K' processes.  Nothing is done unless moons are to be    */
+/*   built straight away, there is more than one process to build them,     */
+/*   and there's no budget that they would all have to share.               */
+/*--------------------------------------------------------------------------*/
+void share_out_moons(void)
+{
+    planet_pointer planet;
+    long planet_count, i;
+    int *fds, ok, status;
+    pid_t *pids;
+    int fd[2];
+    long workers;
+
+    if (!flag_moons || flag_lazy_moons || (flag_moon_workers <= 1)
+        || (flag_max_injections > 0) || (flag_max_sweeps > 0) || (flag_max_msec > 0))
+        return;
+    planet_count = 0;
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        if (planet->mass_type != STAR)
+            planet_count++;
+    }
+    if ((workers = flag_moon_workers) > planet_count)
+        workers = planet_count;
+    if (workers <= 1)
+        return;
+    if (((fds = (int *)malloc((size_t)workers * sizeof(int))) == NULL)
+        || ((pids = (pid_t *)malloc((size_t)workers * sizeof(pid_t))) == NULL)) {
+        perror("malloc'ing moon processes");
+        exit(1);
+    }
+    fflush(stdout);
+    for (i = 0; i < workers; i++) {
+        if (pipe(fd) < 0) {
+            perror("creating a moon pipe");
+            exit(1);
+        }
+        if ((pids[i] = fork()) < 0) {
+            perror("forking a moon process");
+            exit(1);
+        }
+        if (pids[i] == 0) {
+            close(fd[0]);
+            send_moons(fd[1], i, workers);
+            _exit(0);
+        }
+        close(fd[1]);
+        fds[i] = fd[0];
+    }
+    ok = TRUE;
+    for (i = 0; i < workers; i++) {
+        if (!receive_moons(fds[i]))
+            ok = FALSE;
+        close(fds[i]);
+        if ((waitpid(pids[i], &status, 0) < 0) || !WIFEXITED(status)
+            || (WEXITSTATUS(status) != 0))
+            ok = FALSE;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: a moon process quit unexpectedly\n");
+        exit(1);
+    }
+    free(pids);
+    free(fds);
+}
+
+#else /* MULTIPROC */
+
+/*--------------------------------------------------------------------------*/
+/*   Without fork() the moons are built with their planets as usual.        */
+/*--------------------------------------------------------------------------*/
+void share_out_moons(void)
+{
+}
+
+#endif /* MULTIPROC */
@@ -0,0 +1,191 @@
+/*----------------------------------------------------------------------*/
+/*                               output.c                               */
+/*                                                                      */
+/*  Routines for writing out the systems of a batch run.  Output is     */
+/*  written in large blocks, and may optionally be compressed (the -z   */
+/*  flag).  Compressed output is written as a series of gzip members,   */
+/*  each holding only whole systems, so that any block can be           */
+/*  decompressed without the ones before it.  Ordinary tools such as    */
+/*  'zcat' read the whole series as a single stream.                    */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <time.h>
+
+#include	"config.h"
+
+#ifdef HAVE_ZLIB
+#include    <zlib.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern int flag_compress;
+
+/*
+ *  Systems waiting to be compressed, and a count of what's gone through:
+ */
+char *block_text = NULL;
+long block_length = 0;
+long bytes_in = 0;
+long bytes_out = 0;
+clock_t compress_time = 0;
+long output_bytes = 0;                  /* all written, for the journal */
+
+/*--------------------------------------------------------------------------*/
+/*   Get standard output ready for a batch run.                             */
+/*--------------------------------------------------------------------------*/
+void open_output(void)
+{
+    if (setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE) != 0) {
+        perror("buffering output");
+        exit(1);
+    }
+#ifdef HAVE_ZLIB
+    if (flag_compress) {
+        if ((block_text = (char *)malloc(COMPRESS_BLOCK_SIZE)) == NULL) {
+            perror("malloc'ing the compression block");
+            exit(1);
+        }
+    }
+#else
+    if (flag_compress) {
+        fprintf(stderr, "ERROR: this starform was built without zlib, so -z is unavailable\n");
+        exit(1);
+    }
+#endif
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write 'length' bytes straight to standard output.                      */
+/*--------------------------------------------------------------------------*/
+void write_output(char *text, long length)
+{
+    if (fwrite(text, 1, (size_t)length, stdout) != (size_t)length) {
+        perror("writing output");
+        exit(1);
+    }
+    output_bytes += length;
+}
+
+#ifdef HAVE_ZLIB
+/*--------------------------------------------------------------------------*/
+/*   Compress the systems collected so far into one gzip member and write   */
+/*   it out.                                                                */
+/*--------------------------------------------------------------------------*/
+void flush_block(void)
+{
+    z_stream stream;
+    char *packed;
+    uLong packed_size;
+    clock_t start;
+
+    if (block_length == 0)
+        return;
+    start = clock();
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "ERROR: can't start compressing output\n");
+        exit(1);
+    }
+    packed_size = deflateBound(&stream, (uLong)block_length);
+    if ((packed = (char *)malloc((size_t)packed_size)) == NULL) {
+        perror("malloc'ing a compressed block");
+        exit(1);
+    }
+    stream.next_in = (Bytef *)block_text;
+    stream.avail_in = (uInt)block_length;
+    stream.next_out = (Bytef *)packed;
+    stream.avail_out = (uInt)packed_size;
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        fprintf(stderr, "ERROR: compressing a block of output failed\n");
+        exit(1);
+    }
+    deflateEnd(&stream);
+    compress_time += clock() - start;
+    write_output(packed, (long)stream.total_out);
+    bytes_out += (long)stream.total_out;
+    free(packed);
+    block_length = 0;
+}
+#endif
+
+/*--------------------------------------------------------------------------*/
+/*   Hand a finished system to the writer.  Output is fully buffered in     */
+/*   large blocks, so records are written out many at a time.  When         */
+/*   compressing, a block is only closed off between systems.               */
+/*--------------------------------------------------------------------------*/
+void emit_record(char *text, long length)
+{
+#ifdef HAVE_ZLIB
+    if (flag_compress) {
+        bytes_in += length;
+        if (block_length + length > COMPRESS_BLOCK_SIZE) {
+            flush_block();
+        }
+        if (length > COMPRESS_BLOCK_SIZE) {
+            /*
+             *  A single huge system gets a block all to itself:
+             */
+            block_text = (char *)realloc(block_text, (size_t)length);
+            if (block_text == NULL) {
+                perror("malloc'ing the compression block");
+                exit(1);
+            }
+        }
+        memcpy(block_text + block_length, text, (size_t)length);
+        block_length += length;
+        return;
+    }
+#endif
+    write_output(text, length);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out everything handed to the writer so far, and return how many  */
+/*   bytes have been written, so that the batch can be carried on from      */
+/*   there (see journal.c).                                                 */
+/*--------------------------------------------------------------------------*/
+long flush_output(void)
+{
+#ifdef HAVE_ZLIB
+    if (flag_compress)
+        flush_block();
+#endif
+    if (fflush(stdout) != 0) {
+        perror("writing output");
+        exit(1);
+    }
+    return(output_bytes);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Finish off the output of a batch run, and report how well it           */
+/*   compressed.                                                            */
+/*--------------------------------------------------------------------------*/
+void close_output(void)
+{
+#ifdef HAVE_ZLIB
+    double seconds;
+
+    if (flag_compress) {
+        flush_block();
+        free(block_text);
+        block_text = NULL;
+        seconds = (double)compress_time / CLOCKS_PER_SEC;
+        fprintf(stderr, "Compressed %ld bytes to %ld bytes (%.1f:1)",
+                bytes_in, bytes_out,
+                (bytes_out > 0) ? (double)bytes_in / bytes_out : 0.0);
+        if (seconds > 0.0)
+            fprintf(stderr, " at %.1f MB/sec", bytes_in / seconds / 1.0E6);
+        fprintf(stderr, "\n");
+    }
+#endif
+    fflush(stdout);
+}
@@ -0,0 +1,279 @@
+/*----------------------------------------------------------------------*/
+/*                               params.c                               */
+/*                                                                      */
+/*  The physical parameters of the accretion model.  These used to be   */
+/*  fixed in const.h (which still gives their usual values), but they   */
+/*  can now be changed for a run with '-p', as in '-palpha=4.5'.        */
+/*                                                                      */
+/*  A batch can also sweep through a range of values (the -S flag),     */
+/*  making every system of the batch once for each point of the sweep.  */
+/*  The points are either a grid:                                       */
+/*                                                                      */
+/*      -Sgrid,alpha=4:6:5,k=40:60:3      (5 x 3 = 15 points)           */
+/*                                                                      */
+/*  or a Latin hypercube of a given size, in which each parameter's     */
+/*  range is cut into that many slices and each slice used just once:   */
+/*                                                                      */
+/*      -Slhs20,alpha=4:6,k=40:60         (20 points)                   */
+/*                                                                      */
+/*  Each system made in a sweep notes the parameters it was made with.  */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+/*
+ *  The parameters in use, and their names:
+ */
+physics_params physics = {
+	DUST_DENSITY_COEFF,
+	ALPHA,
+	N,
+	K,
+	B,
+	ECCENTRICITY_COEFF,
+	CLOUD_ECCENTRICITY,
+	PROTOPLANET_MASS,
+	GAS_RETENTION_THRESHOLD
+};
+
+parameter_info parameter_table[] = {
+	{"dust_density_coeff",      &physics.dust_density_coeff,         FALSE},
+	{"alpha",                   &physics.alpha,                      FALSE},
+	{"n",                       &physics.n,                          FALSE},
+	{"k",                       &physics.k,                          FALSE},
+	{"b",                       &physics.b,                          FALSE},
+	{"eccentricity_coeff",      &physics.eccentricity_coeff,         FALSE},
+	{"cloud_eccentricity",      &physics.cloud_eccentricity,         FALSE},
+	{"protoplanet_mass",        &physics.protoplanet_mass,           FALSE},
+	{"gas_retention_threshold", &physics.gas_retention_threshold,    FALSE},
+	{NULL,                      NULL,                                FALSE}
+};
+
+/*
+ *  The sweep, if there is one.  The values of a Latin hypercube are
+ *  worked out in advance, 'sweep_axis_count' to a point:
+ */
+int sweep_type = SWEEP_NONE;
+int sweep_axis_count = 0;
+sweep_axis sweep_axes[MAX_SWEEP_AXES];
+long sweep_points = 1;
+double *sweep_values = NULL;
+
+/*--------------------------------------------------------------------------*/
+/*   Find the parameter called 'name', returning NULL if there isn't one.   */
+/*   'length' is the length of the name (it may be followed by a value).    */
+/*--------------------------------------------------------------------------*/
+parameter_info *find_parameter(char *name, int length)
+{
+    parameter_info *param;
+
+    for (param = parameter_table; param->name != NULL; param++) {
+        if ((strncmp(param->name, name, (size_t)length) == 0)
+            && (param->name[length] == '\0'))
+            return(param);
+    }
+    return(NULL);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Set a parameter from an assignment such as "alpha=4.5".  FALSE is      */
+/*   returned if there is no such parameter or the value is no number.     */
+/*--------------------------------------------------------------------------*/
+int set_parameter(char *assignment)
+{
+    parameter_info *param;
+    char *equals, *end;
+    double value;
+
+    if ((equals = strchr(assignment, '=')) == NULL)
+        return(FALSE);
+    if ((param = find_parameter(assignment, (int)(equals - assignment))) == NULL)
+        return(FALSE);
+    value = strtod(equals + 1, &end);
+    if ((end == equals + 1) || (*end != '\0'))
+        return(FALSE);
+    *param->value = value;
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Set a parameter given with '-p', noting that it was given so that it   */
+/*   takes precedence over any value read back from a snapshot.             */
+/*--------------------------------------------------------------------------*/
+int give_parameter(char *assignment)
+{
+    if (!set_parameter(assignment))
+        return(FALSE);
+    find_parameter(assignment, (int)strcspn(assignment, "="))->given = TRUE;
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out all of the parameters in use as a list of assignments, with  */
+/*   every digit of their values, such as "dust_density_coeff=0.002 ...".  */
+/*--------------------------------------------------------------------------*/
+void write_parameters(char *buf)
+{
+    parameter_info *param;
+
+    buf[0] = '\0';
+    for (param = parameter_table; param->name != NULL; param++)
+        sprintf(buf + strlen(buf), "%s%s=%.17g", (param == parameter_table) ? "" : " ",
+                param->name, *param->value);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read a sweep given with '-S'.  FALSE is returned (after saying why)    */
+/*   if it makes no sense.                                                  */
+/*--------------------------------------------------------------------------*/
+int read_sweep(char *spec)
+{
+    char *word, *equals;
+    sweep_axis *axis;
+    int fields, i;
+    long length;
+
+    if ((word = strtok(spec, ",")) == NULL) {
+        fprintf(stderr, "ERROR: empty sweep\n");
+        return(FALSE);
+    }
+    if (strcmp(word, "grid") == 0) {
+        sweep_type = SWEEP_GRID;
+    }
+    else if ((strncmp(word, "lhs", 3) == 0)
+             && (sscanf(word + 3, "%ld", &sweep_points) == 1)
+             && (sweep_points > 0)) {
+        sweep_type = SWEEP_LHS;
+    }
+    else {
+        fprintf(stderr, "ERROR: sweep <%s> should be 'grid' or 'lhs#'\n", word);
+        return(FALSE);
+    }
+    /*
+     *  Room is kept in each task line for the index, seed and moons
+     *  flag, and for each parameter's name and value (see sweep_point):
+     */
+    length = SWEEP_TASK_START;
+    while ((word = strtok(NULL, ",")) != NULL) {
+        if (sweep_axis_count == MAX_SWEEP_AXES) {
+            fprintf(stderr, "ERROR: too many parameters in the sweep\n");
+            return(FALSE);
+        }
+        axis = &sweep_axes[sweep_axis_count];
+        axis->count = 1;
+        if (((equals = strchr(word, '=')) == NULL)
+            || ((axis->param = find_parameter(word, (int)(equals - word))) == NULL)) {
+            fprintf(stderr, "ERROR: unknown parameter in sweep <%s>\n", word);
+            return(FALSE);
+        }
+        for (i = 0; i < sweep_axis_count; i++) {
+            if (sweep_axes[i].param == axis->param) {
+                fprintf(stderr, "ERROR: <%s> is swept more than once\n",
+                        axis->param->name);
+                return(FALSE);
+            }
+        }
+        length += (long)strlen(axis->param->name) + SWEEP_VALUE_SIZE;
+        if (length > TASK_LINE_SIZE) {
+            fprintf(stderr, "ERROR: too many parameters in the sweep\n");
+            return(FALSE);
+        }
+        if (sweep_type == SWEEP_GRID)
+            fields = sscanf(equals + 1, "%lf:%lf:%ld", &axis->low,
+                            &axis->high, &axis->count);
+        else fields = sscanf(equals + 1, "%lf:%lf", &axis->low, &axis->high) + 1;
+        if ((fields != 3) || (axis->count < 1)) {
+            fprintf(stderr, "ERROR: bad range in sweep <%s>\n", word);
+            return(FALSE);
+        }
+        if (sweep_type == SWEEP_GRID)
+            sweep_points *= axis->count;
+        sweep_axis_count++;
+    }
+    if (sweep_axis_count == 0) {
+        fprintf(stderr, "ERROR: the sweep has no parameters\n");
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Work out the points of a Latin hypercube.  Each parameter's range is   */
+/*   cut into 'sweep_points' slices, which are shuffled, and each point     */
+/*   takes a random value within its slice.  The shuffling is done with     */
+/*   'seed', so the same seed always gives the same points.                 */
+/*--------------------------------------------------------------------------*/
+void make_sweep(unsigned seed)
+{
+    long *slices;
+    long point, other, temp;
+    int i;
+
+    if (sweep_type != SWEEP_LHS)
+        return;
+    if (((sweep_values = (double *)malloc((size_t)(sweep_points * sweep_axis_count)
+                                         * sizeof(double))) == NULL)
+        || ((slices = (long *)malloc((size_t)sweep_points * sizeof(long))) == NULL)) {
+        perror("malloc'ing the sweep");
+        exit(1);
+    }
+    seed_random(seed);
+    use_stream(STREAM_SWEEP, 0L);
+    for (i = 0; i < sweep_axis_count; i++) {
+        for (point = 0; point < sweep_points; point++)
+            slices[point] = point;
+        for (point = sweep_points - 1; point > 0; point--) {
+            other = (long)random_number(0.0, (double)point + 0.999999);
+            temp = slices[point];
+            slices[point] = slices[other];
+            slices[other] = temp;
+        }
+        for (point = 0; point < sweep_points; point++) {
+            sweep_values[point * sweep_axis_count + i] = sweep_axes[i].low
+                + (sweep_axes[i].high - sweep_axes[i].low)
+                * (slices[point] + random_number(0.0, 1.0)) / sweep_points;
+        }
+    }
+    free(slices);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out point number 'point' of the sweep as a list of assignments,  */
+/*   such as "alpha=4.5 k=50".                                              */
+/*--------------------------------------------------------------------------*/
+void sweep_point(long point, char *buf)
+{
+    sweep_axis *axis;
+    double value;
+    long place;
+    int i;
+
+    buf[0] = '\0';
+    place = sweep_points;
+    for (i = 0; i < sweep_axis_count; i++) {
+        axis = &sweep_axes[i];
+        if (sweep_type == SWEEP_LHS) {
+            value = sweep_values[point * sweep_axis_count + i];
+        }
+        else {
+            /*
+             *  The first parameter of a grid changes most slowly:
+             */
+            place /= axis->count;
+            if (axis->count == 1)
+                value = axis->low;
+            else value = axis->low + (axis->high - axis->low)
+                         * ((point / place) % axis->count) / (axis->count - 1);
+        }
+        sprintf(buf + strlen(buf), "%s%s=%.6g", (i > 0) ? " " : "",
+                axis->param->name, value);
+    }
+}
@@ -0,0 +1,155 @@
+/*----------------------------------------------------------------------*/
+/*                                pool.c                                */
+/*                                                                      */
+/*  A pool of ready-made random systems for the server (the -P and -B   */
+/*  flags).  Most requests that don't give a seed just want any system  */
+/*  at all, so rather than make them wait while one is built, each      */
+/*  server process builds a few ahead of time while it has nothing      */
+/*  better to do.  Every pooled system keeps the seed it was built      */
+/*  from, so it can be regenerated later like any other.                */
+/*                                                                      */
+/*  Once the pool drops below half full it is refilled, one system at   */
+/*  a time, whenever the server is idle.  The CPU budget keeps the      */
+/*  refilling down to a share of the machine: after a system that took  */
+/*  't' seconds to build, the next one waits long enough that building  */
+/*  takes no more than the budgeted percentage of the time.             */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <time.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern int flag_moons;
+extern int flag_lazy_moons;
+extern int moon_list_count;
+extern int flag_startype;
+extern star_pointer star_specs;
+extern long flag_pool_size;
+extern int flag_pool_budget;
+extern work_budget budget;
+
+/*
+ *  The pool is a ring of 'flag_pool_size' systems, the oldest of which
+ *  is at 'pool_first'.  Pooled systems are all built with or without
+ *  moons, as '-m' says.
+ */
+pool_entry *pool_ring = NULL;
+long pool_first = 0;
+long pool_count = 0;
+int pool_moons = FALSE;
+int pool_refilling = TRUE;
+double pool_next_refill = 0.0;
+
+/*
+ *  How well the pool is doing:
+ */
+long pool_hits = 0;
+long pool_misses = 0;
+long pool_built = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Get the pool ready.  'moons' says whether its systems have moons.      */
+/*--------------------------------------------------------------------------*/
+void open_pool(int moons)
+{
+    if (flag_pool_size <= 0)
+        return;
+    if ((pool_ring = (pool_entry *)calloc((size_t)flag_pool_size,
+                                          sizeof(pool_entry))) == NULL) {
+        perror("malloc'ing the system pool");
+        exit(1);
+    }
+    pool_moons = moons;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Take the oldest system out of the pool.  Its description is returned   */
+/*   (the caller frees it), or NULL if a random system asking for 'moons'   */
+/*   can't be had from the pool.                                            */
+/*--------------------------------------------------------------------------*/
+char *pool_take(int moons, unsigned *seed, long *length, int *tripped)
+{
+    pool_entry *entry;
+
+    if ((pool_ring == NULL) || (moons != pool_moons))
+        return(NULL);
+    if (pool_count == 0) {
+        pool_misses++;
+        pool_refilling = TRUE;
+        return(NULL);
+    }
+    entry = &pool_ring[pool_first];
+    pool_first = (pool_first + 1) % flag_pool_size;
+    pool_count--;
+    if (pool_count < (flag_pool_size + 1) / 2)
+        pool_refilling = TRUE;
+    pool_hits++;
+    *seed = entry->seed;
+    *length = entry->length;
+    *tripped = entry->tripped;
+    return(entry->text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   How many milliseconds until the pool may build another system, or -1   */
+/*   if it doesn't need one.                                                */
+/*--------------------------------------------------------------------------*/
+int pool_wait(void)
+{
+    double delay;
+
+    if ((pool_ring == NULL) || !pool_refilling)
+        return(-1);
+    if ((delay = pool_next_refill - wall_clock()) <= 0.0)
+        return(0);
+    return((int)(delay * 1000.0) + 1);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Build one more system for the pool.                                    */
+/*--------------------------------------------------------------------------*/
+void pool_refill(void)
+{
+    pool_entry *entry;
+    clock_t start;
+    double spent;
+
+    if ((pool_ring == NULL) || (pool_count >= flag_pool_size)) {
+        pool_refilling = FALSE;
+        return;
+    }
+    start = clock();
+    flag_moons = pool_moons;
+    flag_lazy_moons = FALSE;
+    moon_list_count = 0;
+    flag_startype = FALSE;
+    star_specs = NULL;
+    entry = &pool_ring[(pool_first + pool_count) % flag_pool_size];
+    entry->seed = random_seed();
+    entry->text = capture_system(entry->seed, &entry->length);
+    entry->tripped = budget.tripped;
+    pool_count++;
+    pool_built++;
+    if (pool_count >= flag_pool_size)
+        pool_refilling = FALSE;
+    spent = (double)(clock() - start) / CLOCKS_PER_SEC;
+    pool_next_refill = wall_clock()
+                       + spent * (100 - flag_pool_budget) / flag_pool_budget;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Report on the pool as the fields of a JSON object.                     */
+/*--------------------------------------------------------------------------*/
+void pool_report(FILE *fp)
+{
+    fprintf(fp, "\"pool_hits\": %ld, \"pool_misses\": %ld, "
+                "\"pool_built\": %ld, \"pool_level\": %ld, \"pool_size\": %ld",
+            pool_hits, pool_misses, pool_built, pool_count,
+            (pool_ring == NULL) ? 0L : flag_pool_size);
+}
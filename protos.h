@@ -24,6 +24,9 @@ double         accrete_dust(double, double, double, double);
 planet_pointer find_collision (planet_pointer, double, double);
 void           collide_planets(double, double, double, planet_pointer, double);
 void           coalesce_planetesimals(double, double, double, double, double, int);
+void           start_accretion(accretion *, double, double, int, planet_pointer, double);
+int            inject_protoplanet(accretion *);
+planet_pointer finish_accretion(void);
 planet_pointer dist_masses(double, double, int, planet_pointer, double);
 planet_pointer check_planets(planet_pointer, double, double);
 planet_pointer init_planet_list(star_pointer);
@@ -33,8 +36,14 @@ planet_pointer init_planet_list(star_pointer);
  */
 double         power(double, double);
 double         random_number(double, double);
+unsigned long  next_random(void);
+unsigned long  mix_bits(unsigned long);
+void           seed_random(unsigned);
+void           use_stream(int, long);
+unsigned long  stream_start(int, long);
 double         about(double, double);
 double         random_eccentricity(void);
+double         wall_clock(void);
 
 /*
  *	From 'enviro.c':
@@ -69,8 +78,20 @@ void           iterate_surface_temp(planet_pointer *, double);
  *	From 'starform.c':
  */
 void           usage(char *);
+star_pointer   read_startype(char *);
+int            read_star_list(char *, star_pointer *);
+void           free_star_list(star_pointer);
 void           init(void);
+void           start_system(unsigned);
 void           generate_stellar_system(void);
+void           make_stars(void);
+void           size_planet(planet_pointer);
+void           finish_planet(planet_pointer, long);
+void           build_moons(planet_pointer);
+planet_pointer planet_moons(planet_pointer);
+int            read_moon_list(char *);
+int            moons_wanted(long);
+void           free_system(sys_pointer);
 int            main(int, char **);
 
 /*
@@ -85,6 +106,11 @@ int            verify_startype(char, int, char);
 void           startype_error(int, char, int, char);
 double         rand_star_mass(int);
 int            rand_type(void);
+double         type_chance(int);
+double         line_chance(spectral_info *, int);
+int            class_line(spectral_info *, double);
+int            read_star_weights(char *);
+void           weighted_star(star_pointer);
 
 /*
  *	From 'display.c':
@@ -94,3 +120,251 @@ void           describe_star(star_pointer);
 void           describe_system(sys_pointer);
 void           display_system(sys_pointer);
 
+/*
+ *	From 'batch.c':
+ */
+unsigned       first_seed(void);
+void           make_system(unsigned);
+void           write_system(unsigned);
+void           note_truncation(int);
+void           report_truncation(void);
+void           begin_capture(capture_info *);
+char *         end_capture(capture_info *, long *);
+char *         capture_system(unsigned, long *);
+void           open_manifest(void);
+int            read_manifest_line(char *, char *);
+int            next_task_line(long, unsigned, char *);
+char *         run_task(char *, long *, long *);
+void           write_full(int, char *, long);
+int            read_full(int, char *, long);
+void           run_worker(int, int);
+void           start_worker(worker_info *, int, int);
+void           start_workers(worker_info *, int);
+char *         fetch_record(worker_info *, record_header *);
+char *         read_record(worker_info *, record_header *);
+void           send_bytes(int, char *, long);
+void           send_record(int, long, char *, long);
+void           send_summaries(int);
+void           collect_samples(worker_info *);
+void           collect_summaries(worker_info *, int);
+void           write_summaries(void);
+void           generate_batch(void);
+
+/*
+ *	From 'output.c':
+ */
+void           open_output(void);
+void           write_output(char *, long);
+void           flush_block(void);
+void           emit_record(char *, long);
+long           flush_output(void);
+void           close_output(void);
+
+/*
+ *	From 'server.c':
+ */
+char *         json_field(char *, char *);
+int            json_string(char *, char *, char *, int);
+long           json_number(char *, char *, long);
+void           json_write_string(FILE *, char *, long);
+unsigned       random_seed(void);
+char *         build_request(char *, unsigned *, long *, int *, char **);
+void           serve_request(char *, FILE *);
+void           wait_for_input(int);
+int            read_request(int, char *);
+void           serve_stream(FILE *, FILE *);
+void           run_server_worker(int);
+long           start_server_worker(int);
+void           serve_socket(char *);
+void           serve(char *);
+
+/*
+ *	From 'cache.c':
+ */
+unsigned long  cache_hash(char *);
+void           cache_unlink(cache_pointer);
+void           cache_make_newest(cache_pointer);
+void           cache_evict(void);
+void           cache_file_name(char *, unsigned long);
+char *         cache_read_disk(char *, unsigned long, long *);
+void           cache_write_disk(char *, unsigned long, char *, long);
+void           cache_insert(char *, unsigned long, char *, long);
+char *         cache_lookup(char *, long *);
+void           cache_store(char *, char *, long);
+void           cache_report(FILE *);
+
+/*
+ *	From 'pool.c':
+ */
+void           open_pool(int);
+char *         pool_take(int, unsigned *, long *, int *);
+int            pool_wait(void);
+void           pool_refill(void);
+void           pool_report(FILE *);
+
+/*
+ *	From 'step.c':
+ */
+int            over_budget(void);
+char *         budget_names(int);
+void           drop_unfinished(planet_pointer);
+void           start_generation(gen_context *);
+void           resume_generation(gen_context *);
+void           start_planets(gen_context *);
+int            out_of_time(long, long, long, double);
+int            generate_step(gen_context *, long, long);
+
+/*
+ *	From 'params.c':
+ */
+parameter_info *find_parameter(char *, int);
+int            set_parameter(char *);
+int            give_parameter(char *);
+void           write_parameters(char *);
+int            read_sweep(char *);
+void           make_sweep(unsigned);
+void           sweep_point(long, char *);
+
+/*
+ *	From 'snapshot.c':
+ */
+void           make_snapshot(unsigned);
+void           write_snapshot(FILE *, unsigned);
+void           open_catalog(void);
+int            read_snapshot_text(FILE *, char *, long);
+int            load_snapshot_line(char *, planet_pointer **);
+int            load_snapshot(char *, unsigned *);
+void           finish_snapshot(void);
+
+/*
+ *	From 'moons.c':
+ */
+void           send_moons(int, long, long);
+int            receive_moons(int);
+void           share_out_moons(void);
+
+/*
+ *	From 'fields.c':
+ */
+long           field_closure(long);
+int            read_fields(char *);
+void           want_fields(long);
+int            field_needed(long);
+int            field_shown(long);
+
+/*
+ *	From 'search.c':
+ */
+int            read_search(char *);
+double         field_value(planet_pointer, long);
+int            meets_conditions(int, planet_pointer);
+void           generate_to(gen_context *, int);
+int            search_system(unsigned);
+void           note_search(int);
+void           report_search(void);
+
+/*
+ *	From 'census.c':
+ */
+void           add_moment(running_stat *, double, double);
+void           merge_moments(running_stat *, running_stat *);
+double         census_place(census_info *, double);
+double         census_quantile(census_stat *, census_info *, double);
+void           add_value(census_group *, int, double, double);
+census_group  *find_group(char *);
+char          *star_group(star_pointer);
+void           measure_system(void (*)(int, double));
+void           count_value(int, double);
+void           census_system(void);
+int            compare_groups(const void *, const void *);
+void           write_census(FILE *);
+int            find_statistic(char *);
+int            read_census(FILE *);
+int            add_census_input(char *);
+void           merge_census_text(char *, long);
+void           report_census(FILE *);
+void           finish_census(FILE *);
+
+/*
+ *	From 'rank.c':
+ */
+void           start_ranking(void);
+double         similarity(planet_pointer);
+int            ranks_above(ranked_planet *, ranked_planet *);
+void           offer_planet(ranked_planet *);
+void           rank_system(unsigned);
+int            compare_ranks(const void *, const void *);
+void           write_ranking(FILE *);
+int            read_ranking(FILE *);
+
+/*
+ *	From 'sample.c':
+ */
+int            read_sample(char *);
+sample_stratum *find_stratum(char *);
+int            samples_before(sampled_system *, sampled_system *);
+int            sample_wants(sample_stratum *, sampled_system *);
+void           offer_sample(sample_stratum *, sampled_system *);
+void           sample_system(unsigned);
+int            compare_sampled(const void *, const void *);
+int            compare_strata(const void *, const void *);
+void           write_sample(FILE *);
+
+/*
+ *	From 'converge.c':
+ */
+int            read_targets(char *);
+void           target_value(int, double);
+void           measure_targets(void);
+double         interval_width(converge_target *);
+int            add_targets(running_stat *);
+void           report_convergence(void);
+
+/*
+ *	From 'shard.c':
+ */
+int            read_shard(char *);
+int            add_shard_input(char *);
+void           note_setting(char *);
+long           shard_place(long);
+int            next_shard_line(long, unsigned, char *);
+void           start_shard(void);
+void           emit_system(record_header *, char *);
+void           end_shard(void);
+int            open_shard(worker_info *, char *, char *);
+void           merge_shards(void);
+
+/*
+ *	From 'journal.c':
+ */
+void           note_stop(int);
+void           open_journal(void);
+void           start_journal(unsigned);
+void           commit_journal(long);
+int            journal_due(void);
+void           finish_journal(long);
+void           stop_batch(worker_info *, int, long);
+
+/*
+ *	From 'supervise.c':
+ */
+void           pass_task(int, char *);
+void           send_task(worker_info *, char *);
+void           task_done(worker_info *);
+char *         quarantine_task(worker_info *, record_header *, int);
+char *         next_record(worker_info *, int, record_header *, int);
+int            hang_timeout(worker_info *, int);
+void           kill_hung_workers(worker_info *, int);
+void           report_quarantine(void);
+
+/*
+ *	From 'timing.c':
+ */
+double         stage_clock(void);
+void           stage_done(int, double);
+void           add_time(timing_histogram *, double);
+double         time_quantile(timing_histogram *, double);
+void           start_system_timing(void);
+void           end_system_timing(void);
+void           merge_timing(timing_histogram *);
+void           report_timing(void);
@@ -0,0 +1,272 @@
+/*----------------------------------------------------------------------*/
+/*                                rank.c                                */
+/*                                                                      */
+/*  Ranking the planets of a batch by how much like the Earth they are  */
+/*  (the -k flag), keeping only the best few.  Each planet is given an  */
+/*  Earth Similarity Index as it is finished: for each of its radius,   */
+/*  density, escape velocity, surface temperature, surface pressure     */
+/*  and hydrosphere,                                                    */
+/*                                                                      */
+/*      (1 - |x - x0| / (x + x0)) ^ (w / 6)                             */
+/*                                                                      */
+/*  where x0 is the Earth's value and w a weight, all multiplied        */
+/*  together.  The Earth itself scores 1, and a planet with no air or   */
+/*  no water scores 0 (and isn't listed).  The weights of the first     */
+/*  four are those of Schulze-Makuch et al. (2011); the last two are    */
+/*  our own.                                                            */
+/*                                                                      */
+/*  Each worker process keeps its best planets in a heap with the       */
+/*  worst of them on top, so each planet finished costs at most a few   */
+/*  comparisons and the memory used never grows past the size of the    */
+/*  list.  The workers send back their lists at the end of the batch,   */
+/*  and these are merged the same way and written out best first.       */
+/*  Planets that score the same are ranked by their place in the        */
+/*  batch, so the list comes out the same however many processes made   */
+/*  it.                                                                 */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <math.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern long flag_top;
+extern char system_tag[];
+extern long system_index;
+extern double system_weight;
+
+/*
+ *  The Earth's value of each field the index is made from (in the units
+ *  of 'field_value'), and its weight:
+ */
+similarity_info similarity_table[] = {
+	{FIELD_RADIUS,         KM_EARTH_RADIUS, 0.57},
+	{FIELD_DENSITY,        EARTH_DENSITY,   1.07},
+	{FIELD_ESC_VELOCITY,   11.19,           0.70},	/* km/sec            */
+	{FIELD_SURF_TEMP,      288.0,           5.58},	/* Kelvin            */
+	{FIELD_SURF_PRESSURE,  1.0,             1.00},	/* Earth atmospheres */
+	{FIELD_HYDROSPHERE,    0.71,            1.00},
+	{0L,                   0.0,             0.0}
+};
+
+/*
+ *  The best planets so far, as a heap with the worst on top:
+ */
+ranked_planet *ranking = NULL;
+long ranking_count = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Note the fields the index is made from, so that they are worked out    */
+/*   whatever is asked for with -F.                                         */
+/*--------------------------------------------------------------------------*/
+void start_ranking(void)
+{
+    similarity_info *info;
+
+    for (info = similarity_table; info->field != 0L; info++)
+        want_fields(info->field);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Work out the Earth Similarity Index of a finished planet.  Gas giants  */
+/*   score 0.                                                               */
+/*--------------------------------------------------------------------------*/
+double similarity(planet_pointer planet)
+{
+    similarity_info *info;
+    double index, value, count;
+
+    if (planet->mass_type != PLANET)
+        return(0.0);
+    count = 0.0;
+    for (info = similarity_table; info->field != 0L; info++)
+        count++;
+    index = 1.0;
+    for (info = similarity_table; info->field != 0L; info++) {
+        value = field_value(planet, info->field);
+        if (value < 0.0)
+            value = 0.0;
+        index *= pow(1.0 - fabs(value - info->earth) / (value + info->earth),
+                     info->weight / count);
+    }
+    return(index);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if planet 'a' ranks above planet 'b': it scores higher, or the    */
+/*   same but comes earlier in the batch.                                   */
+/*--------------------------------------------------------------------------*/
+int ranks_above(ranked_planet *a, ranked_planet *b)
+{
+    if (a->esi != b->esi)
+        return(a->esi > b->esi);
+    if (a->index != b->index)
+        return(a->index < b->index);
+    return(a->planet < b->planet);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Offer a planet to the ranking.  Until the list is full every planet    */
+/*   goes in; after that, a planet only goes in if it ranks above the worst */
+/*   one, which it replaces.                                                */
+/*--------------------------------------------------------------------------*/
+void offer_planet(ranked_planet *entry)
+{
+    ranked_planet temp;
+    long place, child;
+
+    if (ranking == NULL) {
+        if ((ranking = (ranked_planet *)malloc((size_t)flag_top
+                                               * sizeof(ranked_planet))) == NULL) {
+            perror("malloc'ing the ranking");
+            exit(1);
+        }
+    }
+    if (ranking_count < flag_top) {
+        /*
+         *  Put it at the bottom and move it up past any better planets:
+         */
+        place = ranking_count++;
+        ranking[place] = *entry;
+        while ((place > 0) && ranks_above(&ranking[(place - 1) / 2], &ranking[place])) {
+            temp = ranking[place];
+            ranking[place] = ranking[(place - 1) / 2];
+            ranking[(place - 1) / 2] = temp;
+            place = (place - 1) / 2;
+        }
+        return;
+    }
+    if (!ranks_above(entry, &ranking[0]))
+        return;
+    /*
+     *  Put it on top in place of the worst, and move it down past any
+     *  worse planets:
+     */
+    ranking[0] = *entry;
+    place = 0;
+    while ((child = 2 * place + 1) < ranking_count) {
+        if ((child + 1 < ranking_count) && ranks_above(&ranking[child], &ranking[child + 1]))
+            child++;
+        if (!ranks_above(&ranking[place], &ranking[child]))
+            break;
+        temp = ranking[place];
+        ranking[place] = ranking[child];
+        ranking[child] = temp;
+        place = child;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Offer each rocky planet of the system in 'sys' to the ranking (those   */
+/*   that score 0 aren't worth listing).                                    */
+/*--------------------------------------------------------------------------*/
+void rank_system(unsigned seed)
+{
+    planet_pointer planet;
+    ranked_planet entry;
+    int number;
+
+    number = 0;
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        if (planet->mass_type == STAR)
+            continue;
+        number++;
+        if ((planet->mass_type != PLANET) || (planet->esi <= 0.0))
+            continue;
+        entry.esi = planet->esi;
+        entry.index = system_index;
+        entry.seed = seed;
+        entry.planet = number;
+        entry.radius = field_value(planet, FIELD_RADIUS);
+        entry.density = field_value(planet, FIELD_DENSITY);
+        entry.esc_velocity = field_value(planet, FIELD_ESC_VELOCITY);
+        entry.surf_temp = field_value(planet, FIELD_SURF_TEMP);
+        entry.surf_pressure = field_value(planet, FIELD_SURF_PRESSURE);
+        entry.hydrosphere = field_value(planet, FIELD_HYDROSPHERE);
+        entry.weight = system_weight;
+        strcpy(entry.tag, system_tag);
+        offer_planet(&entry);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   For sorting the ranking best first.                                    */
+/*--------------------------------------------------------------------------*/
+int compare_ranks(const void *a, const void *b)
+{
+    if (ranks_above((ranked_planet *)a, (ranked_planet *)b))
+        return(-1);
+    return(ranks_above((ranked_planet *)b, (ranked_planet *)a));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the ranking, best first, a planet to a line.  Each line      */
+/*   gives the planet's rank and index, the place of its system in the      */
+/*   batch, the seed that makes it (with any parameters it was made with,   */
+/*   at the end of the line), which planet of the system it is, and the     */
+/*   weight of its system (1 unless primaries are chosen by weight).  The   */
+/*   list can be read back by 'read_ranking'.                               */
+/*--------------------------------------------------------------------------*/
+void write_ranking(FILE *fp)
+{
+    ranked_planet *entry;
+    long i;
+
+    qsort(ranking, (size_t)ranking_count, sizeof(ranked_planet), compare_ranks);
+    fprintf(fp, "                         MOST EARTH-LIKE PLANETS\n\n");
+    fprintf(fp, "    rank    ESI     system       seed planet    radius density "
+                "esc vel    temp pressure  water     weight  parameters\n");
+    for (i = 0; i < ranking_count; i++) {
+        entry = &ranking[i];
+        fprintf(fp, "%8ld %.4f %10ld %10u %6d %9.1f %7.3f %7.2f %7.2f %8.3f %6.3f %10.4g",
+                i + 1, entry->esi, entry->index, entry->seed, entry->planet,
+                entry->radius, entry->density, entry->esc_velocity,
+                entry->surf_temp, entry->surf_pressure, entry->hydrosphere,
+                entry->weight);
+        if (entry->tag[0] != '\0')
+            fprintf(fp, "  %s", entry->tag);
+        fprintf(fp, "\n");
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read a ranking written by 'write_ranking' and merge it into this one.  */
+/*   Lines that aren't planets are skipped, and planets listed before       */
+/*   systems were weighted are given a weight of 1.  The scores are only    */
+/*   given to four places, so a planet read back ranks a little differently */
+/*   among planets whose full scores are very close.                        */
+/*--------------------------------------------------------------------------*/
+int read_ranking(FILE *fp)
+{
+    char line[SNAPSHOT_LINE_SIZE];
+    ranked_planet entry;
+    long rank;
+    int offset, extra;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        offset = 0;
+        if (sscanf(line, "%ld %lf %ld %u %d %lf %lf %lf %lf %lf %lf %n", &rank,
+                   &entry.esi, &entry.index, &entry.seed, &entry.planet,
+                   &entry.radius, &entry.density, &entry.esc_velocity,
+                   &entry.surf_temp, &entry.surf_pressure, &entry.hydrosphere,
+                   &offset) != 11)
+            continue;
+        line[strcspn(line, "\n")] = '\0';
+        extra = 0;
+        entry.weight = 1.0;
+        if ((offset > 0) && (sscanf(line + offset, "%lf %n", &entry.weight, &extra) == 1))
+            offset += extra;
+        if ((offset == 0) || (strlen(line + offset) >= TASK_LINE_SIZE))
+            return(FALSE);
+        strcpy(entry.tag, line + offset);
+        offer_planet(&entry);
+    }
+    return(TRUE);
+}
@@ -0,0 +1,303 @@
+/*----------------------------------------------------------------------*/
+/*                               sample.c                               */
+/*                                                                      */
+/*  A random sample of the systems of a batch, written out in full in   */
+/*  place of the whole batch (the -r flag).  With '-r#' each system     */
+/*  has the same chance of being one of the # sampled; with '-r#,star'  */
+/*  or '-r#,planets' (or both) # are also sampled from each kind of     */
+/*  primary or each number of planets, so that rare kinds of system     */
+/*  turn up as well as common ones.                                     */
+/*                                                                      */
+/*  Each system is given a random key, made from its seed and its       */
+/*  place in the batch, and a sample is simply the systems with the     */
+/*  # smallest keys.  This picks systems just as fairly as a reservoir  */
+/*  does, but the choice doesn't depend on the order the systems are    */
+/*  seen in: each worker process keeps the systems with the smallest    */
+/*  keys of those it made, in a heap with the largest on top, and when  */
+/*  the batch is over these are merged the same way.  The sample is     */
+/*  then the same however many processes made it.  A system is only     */
+/*  described if its key is small enough to be kept, so the rest of a   */
+/*  large batch costs no more than its census or ranking.               */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern long flag_sample;
+extern long system_index;
+
+/*
+ *  How the systems are sampled (SAMPLE_BY_STAR, ...), and the samples
+ *  so far:
+ */
+int sample_strata = 0;
+sample_stratum strata[MAX_SAMPLE_STRATA];
+int stratum_count = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Decode the '-r' flag: the size of each sample, then optionally ",star" */
+/*   and ",planets".  FALSE is returned if it can't be understood.          */
+/*--------------------------------------------------------------------------*/
+int read_sample(char *spec)
+{
+    char *c;
+
+    flag_sample = strtol(spec, &c, 10);
+    if ((c == spec) || (flag_sample < 1)) {
+        fprintf(stderr, "ERROR: bad sample <%s>\n", spec);
+        return(FALSE);
+    }
+    while (*c == ',') {
+        c++;
+        if (strncmp(c, "star", 4) == 0) {
+            sample_strata |= SAMPLE_BY_STAR;
+            c += 4;
+        }
+        else if (strncmp(c, "planets", 7) == 0) {
+            sample_strata |= SAMPLE_BY_PLANETS;
+            c += 7;
+        }
+        else break;
+    }
+    if (*c != '\0') {
+        fprintf(stderr, "ERROR: bad sample <%s>\n", spec);
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Find the sample with the given name, starting it if need be.           */
+/*--------------------------------------------------------------------------*/
+sample_stratum *find_stratum(char *name)
+{
+    sample_stratum *stratum;
+    int i;
+
+    for (i = 0; i < stratum_count; i++) {
+        if (strcmp(strata[i].name, name) == 0)
+            return(&strata[i]);
+    }
+    if (stratum_count == MAX_SAMPLE_STRATA) {
+        fprintf(stderr, "ERROR: too many kinds of system to sample\n");
+        exit(1);
+    }
+    stratum = &strata[stratum_count++];
+    memset(stratum, 0, sizeof(sample_stratum));
+    strncpy(stratum->name, name, STRATUM_NAME_SIZE - 1);
+    if ((stratum->kept = (sampled_system *)malloc((size_t)flag_sample
+                                                  * sizeof(sampled_system))) == NULL) {
+        perror("malloc'ing a sample");
+        exit(1);
+    }
+    return(stratum);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if system 'a' comes before system 'b' in a sample: its key is     */
+/*   smaller, or the same but it comes earlier in the batch.                */
+/*--------------------------------------------------------------------------*/
+int samples_before(sampled_system *a, sampled_system *b)
+{
+    if (a->key != b->key)
+        return(a->key < b->key);
+    return(a->index < b->index);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if a system with this key would be kept in the sample: it isn't   */
+/*   full yet, or the system comes before the last one in it.               */
+/*--------------------------------------------------------------------------*/
+int sample_wants(sample_stratum *stratum, sampled_system *entry)
+{
+    return((stratum->count < flag_sample) || samples_before(entry, &stratum->kept[0]));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Offer a system to a sample.  The sample takes over its text, which is  */
+/*   freed if the system isn't kept or is later pushed out.                 */
+/*--------------------------------------------------------------------------*/
+void offer_sample(sample_stratum *stratum, sampled_system *entry)
+{
+    sampled_system temp;
+    long place, child;
+
+    if (!sample_wants(stratum, entry)) {
+        free(entry->text);
+        return;
+    }
+    if (stratum->count < flag_sample) {
+        /*
+         *  Put it at the bottom and move it up past any smaller keys:
+         */
+        place = stratum->count++;
+        stratum->kept[place] = *entry;
+        while ((place > 0)
+               && samples_before(&stratum->kept[(place - 1) / 2], &stratum->kept[place])) {
+            temp = stratum->kept[place];
+            stratum->kept[place] = stratum->kept[(place - 1) / 2];
+            stratum->kept[(place - 1) / 2] = temp;
+            place = (place - 1) / 2;
+        }
+        return;
+    }
+    /*
+     *  Put it on top in place of the largest key, and move it down past
+     *  any larger ones:
+     */
+    free(stratum->kept[0].text);
+    stratum->kept[0] = *entry;
+    place = 0;
+    while ((child = 2 * place + 1) < stratum->count) {
+        if ((child + 1 < stratum->count)
+            && samples_before(&stratum->kept[child], &stratum->kept[child + 1]))
+            child++;
+        if (!samples_before(&stratum->kept[place], &stratum->kept[child]))
+            break;
+        temp = stratum->kept[place];
+        stratum->kept[place] = stratum->kept[child];
+        stratum->kept[child] = temp;
+        place = child;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Offer the system in 'sys' to the sample of all systems and, if the     */
+/*   samples are split up, to that of its kind.  It is only described if    */
+/*   one of them keeps it.                                                  */
+/*--------------------------------------------------------------------------*/
+void sample_system(unsigned seed)
+{
+    planet_pointer planet;
+    sampled_system entry;
+    capture_info capture;
+    char name[STRATUM_NAME_SIZE];
+    char *names[2];
+    char *text;
+    long length;
+    int i, count, planets;
+
+    names[0] = "all";
+    count = 1;
+    if (sample_strata != 0) {
+        name[0] = '\0';
+        if (sample_strata & SAMPLE_BY_STAR)
+            strcpy(name, star_group(sys.primary_star));
+        if (sample_strata & SAMPLE_BY_PLANETS) {
+            planets = 0;
+            for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+                if (planet->mass_type != STAR)
+                    planets++;
+            }
+            sprintf(name + strlen(name), "%s%d planet%s",
+                    (name[0] != '\0') ? ", " : "", planets, (planets == 1) ? "" : "s");
+        }
+        names[count++] = name;
+    }
+    entry.key = mix_bits(mix_bits((unsigned long)system_index)
+                         ^ ((unsigned long)seed * 0x9E3779B9UL));
+    entry.index = system_index;
+    text = NULL;
+    for (i = 0; i < count; i++) {
+        find_stratum(names[i])->systems++;
+        if (!sample_wants(find_stratum(names[i]), &entry))
+            continue;
+        if (text == NULL) {
+            begin_capture(&capture);
+            write_system(seed);
+            text = end_capture(&capture, &length);
+            entry.text = text;
+        }
+        else {
+            if ((entry.text = (char *)malloc((size_t)length + 1)) == NULL) {
+                perror("malloc'ing a sampled system");
+                exit(1);
+            }
+            memcpy(entry.text, text, (size_t)length + 1);
+        }
+        entry.length = length;
+        offer_sample(find_stratum(names[i]), &entry);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   For sorting the sampled systems into the order of the batch, and for   */
+/*   sorting the samples by name.                                           */
+/*--------------------------------------------------------------------------*/
+int compare_sampled(const void *a, const void *b)
+{
+    sampled_system *first = *(sampled_system **)a;
+    sampled_system *second = *(sampled_system **)b;
+
+    if (first->index != second->index)
+        return((first->index < second->index) ? -1 : 1);
+    return(first->stratum - second->stratum);
+}
+
+int compare_strata(const void *a, const void *b)
+{
+    sample_stratum *first = (sample_stratum *)a;
+    sample_stratum *second = (sample_stratum *)b;
+
+    if (strcmp(first->name, second->name) == 0)
+        return(0);
+    if (strcmp(first->name, "all") == 0)
+        return(-1);
+    if (strcmp(second->name, "all") == 0)
+        return(1);
+    return(strcmp(first->name, second->name));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the samples: first how many systems of each kind were made   */
+/*   and how many of them were sampled (from which the share of each kind   */
+/*   in the batch can be worked out), then the sampled systems themselves   */
+/*   in the order of the batch.  A system in more than one sample is only   */
+/*   written once, headed by the samples it is in.                          */
+/*--------------------------------------------------------------------------*/
+void write_sample(FILE *fp)
+{
+    sampled_system **entries;
+    long i, j, total;
+    int k;
+
+    qsort(strata, (size_t)stratum_count, sizeof(sample_stratum), compare_strata);
+    fprintf(fp, "                            SAMPLED SYSTEMS\n\n");
+    fprintf(fp, "       systems    sampled  kind\n");
+    total = 0;
+    for (k = 0; k < stratum_count; k++) {
+        fprintf(fp, "%14ld %10ld  %s\n",
+                strata[k].systems, strata[k].count, strata[k].name);
+        total += strata[k].count;
+    }
+    fprintf(fp, "\n");
+    if ((entries = (sampled_system **)malloc((size_t)(total + 1)
+                                              * sizeof(sampled_system *))) == NULL) {
+        perror("malloc'ing the sampled systems");
+        exit(1);
+    }
+    total = 0;
+    for (k = 0; k < stratum_count; k++) {
+        for (i = 0; i < strata[k].count; i++) {
+            strata[k].kept[i].stratum = k;
+            entries[total++] = &strata[k].kept[i];
+        }
+    }
+    qsort(entries, (size_t)total, sizeof(sampled_system *), compare_sampled);
+    for (i = 0; i < total; i = j) {
+        fprintf(fp, "Sample - ");
+        for (j = i; (j < total) && (entries[j]->index == entries[i]->index); j++)
+            fprintf(fp, "%s%s", (j > i) ? "; " : "", strata[entries[j]->stratum].name);
+        fprintf(fp, "\n");
+        fwrite(entries[i]->text, 1, (size_t)entries[i]->length, fp);
+    }
+    free(entries);
+}
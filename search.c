@@ -0,0 +1,353 @@
+/*----------------------------------------------------------------------*/
+/*                               search.c                               */
+/*                                                                      */
+/*  Searching a batch for systems that meet some conditions (the -Q     */
+/*  flag), such as a planet with a surface temperature of 270 to 310 K  */
+/*  and a pressure of half to two atmospheres about a G or K main       */
+/*  sequence primary:                                                   */
+/*                                                                      */
+/*     -Qspectral=GK,luminosity=V,surf_temp=270:310,surf_pressure=.5:2  */
+/*                                                                      */
+/*  Only the systems that meet them all are written out.  Conditions    */
+/*  on the stars are checked as soon as the stars are settled, before   */
+/*  any accretion is done.  Conditions on the orbit, mass and type of   */
+/*  a planet are checked once accretion is over, and those on its       */
+/*  environment (any of the fields of the -F flag) as each planet that  */
+/*  passed the others is finished.  The first planet to pass them all   */
+/*  settles it, and only then are the rest of the planets finished.     */
+/*  Each system is rejected at the first stage it can be, and the end   */
+/*  of the batch reports how many were rejected at each.                */
+/*                                                                      */
+/*  Ranges are given as "low:high" (either end may be left off), in     */
+/*  the units the model works in, except for the surface pressure (in   */
+/*  Earth atmospheres), the escape velocity (in km/sec) and the masses  */
+/*  of planets (in Earth masses) and stars (in solar masses).           */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern int flag_lazy_moons;
+extern int snapshot_loaded;
+extern char *flag_search;
+
+/*
+ *  The conditions that can be given, and the stage after which each is
+ *  decided:
+ */
+search_term search_table[] = {
+	{"spectral",               TERM_SPECTRAL,   STAGE_STARS,     0L},
+	{"luminosity",             TERM_LUMINOSITY, STAGE_STARS,     0L},
+	{"stars",                  TERM_STARS,      STAGE_STARS,     0L},
+	{"star_mass",              TERM_STAR_MASS,  STAGE_STARS,     0L},
+	{"a",                      TERM_A,          STAGE_ACCRETION, 0L},
+	{"e",                      TERM_E,          STAGE_ACCRETION, 0L},
+	{"mass",                   TERM_MASS,       STAGE_ACCRETION, 0L},
+	{"type",                   TERM_TYPE,       STAGE_ACCRETION, 0L},
+	{"radius",                 TERM_FIELD,      STAGE_PLANETS,   FIELD_RADIUS},
+	{"density",                TERM_FIELD,      STAGE_PLANETS,   FIELD_DENSITY},
+	{"orb_period",             TERM_FIELD,      STAGE_PLANETS,   FIELD_ORB_PERIOD},
+	{"day",                    TERM_FIELD,      STAGE_PLANETS,   FIELD_DAY},
+	{"axial_tilt",             TERM_FIELD,      STAGE_PLANETS,   FIELD_AXIAL_TILT},
+	{"esc_velocity",           TERM_FIELD,      STAGE_PLANETS,   FIELD_ESC_VELOCITY},
+	{"surf_accel",             TERM_FIELD,      STAGE_PLANETS,   FIELD_SURF_ACCEL},
+	{"rms_velocity",           TERM_FIELD,      STAGE_PLANETS,   FIELD_RMS_VELOCITY},
+	{"molec_weight",           TERM_FIELD,      STAGE_PLANETS,   FIELD_MOLEC_WEIGHT},
+	{"surf_grav",              TERM_FIELD,      STAGE_PLANETS,   FIELD_SURF_GRAV},
+	{"greenhouse_effect",      TERM_FIELD,      STAGE_PLANETS,   FIELD_GREENHOUSE},
+	{"volatile_gas_inventory", TERM_FIELD,      STAGE_PLANETS,   FIELD_VOLATILES},
+	{"surf_pressure",          TERM_FIELD,      STAGE_PLANETS,   FIELD_SURF_PRESSURE},
+	{"boil_point",             TERM_FIELD,      STAGE_PLANETS,   FIELD_BOIL_POINT},
+	{"surf_temp",              TERM_FIELD,      STAGE_PLANETS,   FIELD_SURF_TEMP},
+	{"albedo",                 TERM_FIELD,      STAGE_PLANETS,   FIELD_ALBEDO},
+	{"hydrosphere",            TERM_FIELD,      STAGE_PLANETS,   FIELD_HYDROSPHERE},
+	{"cloud_cover",            TERM_FIELD,      STAGE_PLANETS,   FIELD_CLOUD_COVER},
+	{"ice_cover",              TERM_FIELD,      STAGE_PLANETS,   FIELD_ICE_COVER},
+	{NULL,                     0,               0,               0L}
+};
+
+/*
+ *  The conditions of the search, and how the systems searched have
+ *  fared:
+ */
+search_condition search_conditions[MAX_SEARCH_TERMS];
+int search_condition_count = 0;
+int search_rejected = REJECTED_NONE;
+long searched_systems = 0;
+long rejected_systems[REJECTED_ENVIRONMENT + 1];
+
+/*--------------------------------------------------------------------------*/
+/*   Read the conditions given with '-Q', separated by commas.  FALSE is    */
+/*   returned (after saying why) if any makes no sense.  Note that 'spec'   */
+/*   is broken up in the process.                                           */
+/*--------------------------------------------------------------------------*/
+int read_search(char *spec)
+{
+    search_condition *condition;
+    search_term *term;
+    char *word, *equals, *colon, *end;
+
+    for (word = strtok(spec, ","); word != NULL; word = strtok(NULL, ",")) {
+        if (search_condition_count == MAX_SEARCH_TERMS) {
+            fprintf(stderr, "ERROR: too many conditions in the search\n");
+            return(FALSE);
+        }
+        condition = &search_conditions[search_condition_count];
+        if ((equals = strchr(word, '=')) == NULL) {
+            fprintf(stderr, "ERROR: search condition <%s> has no '='\n", word);
+            return(FALSE);
+        }
+        for (term = search_table; term->name != NULL; term++) {
+            if ((strncmp(term->name, word, (size_t)(equals - word)) == 0)
+                && (term->name[equals - word] == '\0'))
+                break;
+        }
+        if (term->name == NULL) {
+            fprintf(stderr, "ERROR: unknown search condition <%s>\n", word);
+            return(FALSE);
+        }
+        condition->term = term;
+        condition->low = -1.0E300;
+        condition->high = 1.0E300;
+        condition->text[0] = '\0';
+        if ((term->kind == TERM_SPECTRAL) || (term->kind == TERM_LUMINOSITY)) {
+            if ((equals[1] == '\0') || (strlen(equals + 1) >= CLASSIFICATION_SIZE)) {
+                fprintf(stderr, "ERROR: bad classes in search <%s>\n", word);
+                return(FALSE);
+            }
+            strcpy(condition->text, equals + 1);
+        }
+        else if (term->kind == TERM_TYPE) {
+            if (strcmp(equals + 1, "rocky") == 0)
+                condition->low = condition->high = PLANET;
+            else if (strcmp(equals + 1, "gas_giant") == 0)
+                condition->low = condition->high = GAS_GIANT;
+            else {
+                fprintf(stderr, "ERROR: search type <%s> should be 'rocky' or "
+                                "'gas_giant'\n", word);
+                return(FALSE);
+            }
+        }
+        else {
+            /*
+             *  A range, "low:high", or a single value:
+             */
+            colon = strchr(equals + 1, ':');
+            if (colon != equals + 1) {
+                condition->low = strtod(equals + 1, &end);
+                if ((end == equals + 1)
+                    || ((colon == NULL) ? (*end != '\0') : (end != colon))) {
+                    fprintf(stderr, "ERROR: bad range in search <%s>\n", word);
+                    return(FALSE);
+                }
+            }
+            if (colon == NULL)
+                condition->high = condition->low;
+            else if (colon[1] != '\0') {
+                condition->high = strtod(colon + 1, &end);
+                if ((end == colon + 1) || (*end != '\0')) {
+                    fprintf(stderr, "ERROR: bad range in search <%s>\n", word);
+                    return(FALSE);
+                }
+            }
+        }
+        want_fields(term->field);
+        search_condition_count++;
+    }
+    if (search_condition_count == 0) {
+        fprintf(stderr, "ERROR: the search has no conditions\n");
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The value of a field of a finished planet, in the units used by the    */
+/*   search.                                                                */
+/*--------------------------------------------------------------------------*/
+double field_value(planet_pointer planet, long field)
+{
+    switch (field) {
+        case FIELD_RADIUS:         return(planet->radius);
+        case FIELD_DENSITY:        return(planet->density);
+        case FIELD_ORB_PERIOD:     return(planet->orb_period);
+        case FIELD_DAY:            return(planet->day);
+        case FIELD_AXIAL_TILT:     return((double)planet->axial_tilt);
+        case FIELD_ESC_VELOCITY:   return(planet->esc_velocity / CM_PER_KM);
+        case FIELD_SURF_ACCEL:     return(planet->surf_accel);
+        case FIELD_RMS_VELOCITY:   return(planet->rms_velocity);
+        case FIELD_MOLEC_WEIGHT:   return(planet->molec_weight);
+        case FIELD_SURF_GRAV:      return(planet->surf_grav);
+        case FIELD_GREENHOUSE:     return((double)planet->greenhouse_effect);
+        case FIELD_VOLATILES:      return(planet->volatile_gas_inventory);
+        case FIELD_SURF_PRESSURE:  return(planet->surf_pressure
+                                          / EARTH_SURF_PRES_IN_MILLIBARS);
+        case FIELD_BOIL_POINT:     return(planet->boil_point);
+        case FIELD_SURF_TEMP:      return(planet->surf_temp);
+        case FIELD_ALBEDO:         return(planet->albedo);
+        case FIELD_HYDROSPHERE:    return(planet->hydrosphere);
+        case FIELD_CLOUD_COVER:    return(planet->cloud_cover);
+        case FIELD_ICE_COVER:      return(planet->ice_cover);
+    }
+    return(0.0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE if the system's stars, or the planet 'planet', meet every         */
+/*   condition of the search decided after 'stage'.  Conditions short-      */
+/*   circuit: the first one failed settles it.                              */
+/*--------------------------------------------------------------------------*/
+int meets_conditions(int stage, planet_pointer planet)
+{
+    search_condition *condition;
+    star_pointer star;
+    char *classes;
+    double value;
+    int i;
+
+    for (i = 0; i < search_condition_count; i++) {
+        condition = &search_conditions[i];
+        if (condition->term->stage != stage)
+            continue;
+        switch (condition->term->kind) {
+            case TERM_SPECTRAL:
+                if (strchr(condition->text, sys.primary_star->star_type[0]) == NULL)
+                    return(FALSE);
+                continue;
+            case TERM_LUMINOSITY:
+                classes = strchr(sys.primary_star->star_type, ' ');
+                if ((classes == NULL) || (strcmp(classes + 1, condition->text) != 0))
+                    return(FALSE);
+                continue;
+            case TERM_STARS:
+                value = 0.0;
+                for (star = sys.primary_star; star != NULL; star = star->next_star)
+                    value++;
+                break;
+            case TERM_STAR_MASS:
+                value = sys.primary_star->stell_mass_ratio;
+                break;
+            case TERM_A:
+                value = planet->a;
+                break;
+            case TERM_E:
+                value = planet->e;
+                break;
+            case TERM_MASS:
+                value = planet->mass * SUN_MASS_IN_EARTH_MASSES;
+                break;
+            case TERM_TYPE:
+                value = (double)planet->mass_type;
+                break;
+            default:
+                value = field_value(planet, condition->term->field);
+                break;
+        }
+        if ((value < condition->low) || (value > condition->high))
+            return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Run the whole generation of one system with 'context', as far as its   */
+/*   'last_stage'.                                                          */
+/*--------------------------------------------------------------------------*/
+void generate_to(gen_context *context, int last_stage)
+{
+    context->last_stage = last_stage;
+    while (generate_step(context, 0L, 0L) != GEN_DONE)
+        ;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Generate the system for one seed (or finish the one read back from a   */
+/*   snapshot), stopping as soon as it is found not to meet the search.     */
+/*   REJECTED_NONE is returned if it does, with the system finished in      */
+/*   'sys'; otherwise the stage at which it was rejected is returned.       */
+/*   The planets tried are finished without their moons, which are only     */
+/*   built if the system is kept.                                           */
+/*--------------------------------------------------------------------------*/
+int search_system(unsigned seed)
+{
+    gen_context context;
+    planet_pointer planet;
+    long number;
+    int found, lazy;
+
+    if (!snapshot_loaded) {
+        seed_random(seed);
+        start_generation(&context);
+        generate_to(&context, STAGE_STARS);
+    }
+    if (!meets_conditions(STAGE_STARS, NULL))
+        return(REJECTED_STARS);
+    if (!snapshot_loaded)
+        generate_to(&context, STAGE_ACCRETION);
+    found = FALSE;
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        if ((planet->mass_type != STAR) && meets_conditions(STAGE_ACCRETION, planet))
+            found = TRUE;
+    }
+    if (!found)
+        return(REJECTED_ORBITS);
+    /*
+     *  Each planet draws on a stream of random numbers of its own, so
+     *  they can be finished out of turn:
+     */
+    lazy = flag_lazy_moons;
+    flag_lazy_moons = TRUE;
+    found = FALSE;
+    number = 0;
+    for (planet = sys.inner_planet; (planet != NULL) && !found;
+         planet = planet->next_planet) {
+        if (planet->mass_type == STAR)
+            continue;
+        if (meets_conditions(STAGE_ACCRETION, planet)) {
+            finish_planet(planet, number);
+            found = meets_conditions(STAGE_PLANETS, planet);
+        }
+        number++;
+    }
+    flag_lazy_moons = lazy;
+    if (!found)
+        return(REJECTED_ENVIRONMENT);
+    if (snapshot_loaded)
+        finish_snapshot();
+    else {
+        start_planets(&context);
+        generate_to(&context, STAGE_PLANETS);
+    }
+    return(REJECTED_NONE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Count a searched system against the stage it was rejected at, and at   */
+/*   the end of the batch report how the search went.                       */
+/*--------------------------------------------------------------------------*/
+void note_search(int rejected)
+{
+    if (flag_search == NULL)
+        return;
+    searched_systems++;
+    rejected_systems[rejected]++;
+}
+
+void report_search(void)
+{
+    if (flag_search == NULL)
+        return;
+    fprintf(stderr, "%ld of %ld systems found (%ld rejected on their stars, "
+                    "%ld on their orbits, %ld on their environment)\n",
+            rejected_systems[REJECTED_NONE], searched_systems,
+            rejected_systems[REJECTED_STARS], rejected_systems[REJECTED_ORBITS],
+            rejected_systems[REJECTED_ENVIRONMENT]);
+}
@@ -0,0 +1,543 @@
+/*----------------------------------------------------------------------*/
+/*                               server.c                               */
+/*                                                                      */
+/*  Routines for running starform as a long-lived generator (the -L     */
+/*  flag), so that a program wanting many systems doesn't have to start */
+/*  a new starform for each one.  Requests and replies are single lines */
+/*  of JSON, such as:                                                   */
+/*                                                                      */
+/*      {"seed": 42, "stars": "G2M/0 K1D/23", "moons": true}            */
+/*      {"seed": 42, "format": "text", "text": "SYSTEM ..."}            */
+/*                                                                      */
+/*  Rather than all the moons, a request can ask for the moons of just  */
+/*  a few planets, as in {"seed": 42, "moons_of": "3 5"}.  The others'  */
+/*  moons are then never accreted.                                      */
+/*                                                                      */
+/*  Every field of a request is optional; without a seed, a random      */
+/*  system is generated.  With '-L-' requests are read from standard    */
+/*  input and replies written to standard output.  Otherwise the flag   */
+/*  names a Unix-domain socket, and connections to it are answered by   */
+/*  a pool of '-j' worker processes.  A request of {"stats": true}      */
+/*  reports on the cache (see cache.c) and the pool of ready-made       */
+/*  systems (see pool.c) of the process answering it.                   */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <ctype.h>
+#include    <sys/types.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <errno.h>
+#include    <fcntl.h>
+#include    <poll.h>
+#include    <signal.h>
+#include    <unistd.h>
+#include    <sys/socket.h>
+#include    <sys/un.h>
+#include    <sys/wait.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern int flag_moons;
+extern int flag_lazy_moons;
+extern long moon_list[];
+extern int moon_list_count;
+extern int flag_startype;
+extern int flag_workers;
+extern star_pointer star_specs;
+extern long flag_cache_size;
+extern char *flag_cache_dir;
+extern work_budget budget;
+extern long shown_fields;
+
+/*--------------------------------------------------------------------------*/
+/*   Find the value of field 'key' in a one-line JSON object.  A pointer    */
+/*   to the first character of the value is returned, or NULL if the        */
+/*   field isn't there.  This is only meant for the flat requests above.    */
+/*--------------------------------------------------------------------------*/
+char *json_field(char *line, char *key)
+{
+    char *p;
+    size_t length;
+
+    length = strlen(key);
+    for (p = line; (p = strchr(p, '"')) != NULL; p++) {
+        if ((strncmp(p + 1, key, length) == 0) && (p[length + 1] == '"')) {
+            p += length + 2;
+            while (isspace((unsigned char)*p))
+                p++;
+            if (*p != ':')
+                continue;
+            p++;
+            while (isspace((unsigned char)*p))
+                p++;
+            return(p);
+        }
+    }
+    return(NULL);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Copy the string value of field 'key' into 'buf'.  An array of strings  */
+/*   is copied as its members separated by spaces.  FALSE is returned if    */
+/*   the field is missing.                                                  */
+/*--------------------------------------------------------------------------*/
+int json_string(char *line, char *key, char *buf, int size)
+{
+    char *p;
+    int i = 0;
+    int in_array;
+
+    if ((p = json_field(line, key)) == NULL)
+        return(FALSE);
+    in_array = (*p == '[');
+    while ((*p != '\0') && (i < size - 1)) {
+        if (*p == '"') {
+            for (p++; (*p != '\0') && (*p != '"') && (i < size - 1); p++)
+                buf[i++] = *p;
+            if (!in_array)
+                break;
+            if (i < size - 1)
+                buf[i++] = ' ';
+        }
+        else if (!in_array || (*p == ']'))
+            break;
+        if (*p != '\0')
+            p++;
+    }
+    buf[i] = '\0';
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Return the numeric (or true/false) value of field 'key', or 'missing'  */
+/*   if the field isn't there.                                              */
+/*--------------------------------------------------------------------------*/
+long json_number(char *line, char *key, long missing)
+{
+    char *p;
+
+    if ((p = json_field(line, key)) == NULL)
+        return(missing);
+    if (strncmp(p, "true", 4) == 0)
+        return(TRUE);
+    if (strncmp(p, "false", 5) == 0)
+        return(FALSE);
+    if (*p == '"')
+        p++;
+    return(atol(p));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write 'text' as a JSON string.                                         */
+/*--------------------------------------------------------------------------*/
+void json_write_string(FILE *fp, char *text, long length)
+{
+    long i;
+
+    putc('"', fp);
+    for (i = 0; i < length; i++) {
+        switch (text[i]) {
+            case '"':
+                fputs("\\\"", fp);
+                break;
+            case '\\':
+                fputs("\\\\", fp);
+                break;
+            case '\n':
+                fputs("\\n", fp);
+                break;
+            case '\t':
+                fputs("\\t", fp);
+                break;
+            default:
+                if ((unsigned char)text[i] < ' ')
+                    fprintf(fp, "\\u%04x", (unsigned char)text[i]);
+                else putc(text[i], fp);
+                break;
+        }
+    }
+    putc('"', fp);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Come up with a seed for a request that didn't give one.  The clock     */
+/*   alone isn't enough, since many requests arrive each millisecond.       */
+/*--------------------------------------------------------------------------*/
+unsigned random_seed(void)
+{
+    static unsigned count = 0;
+    unsigned seed;
+    double now;
+    long seconds;
+
+    now = wall_clock();
+    seconds = (long)now;
+    seed = (unsigned)(seconds * 1000L + (long)((now - seconds) * 1000.0));
+#ifdef MULTIPROC
+    seed += (unsigned)getpid() * 40503U;
+#endif
+    seed = seed * 2654435761U + ++count * 97U;
+    if (seed == 0)
+        seed = 1;
+    return(seed);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Build the system asked for by 'request' and return its description in  */
+/*   a newly allocated buffer.  NULL is returned (with 'error' filled in)   */
+/*   if the request can't be understood.  Requests that give a seed are     */
+/*   answered from the cache when possible.  'tripped' is set to the work   */
+/*   budgets the system ran out of; systems cut short are never cached.     */
+/*--------------------------------------------------------------------------*/
+char *build_request(char *request, unsigned *seed, long *length, int *tripped,
+                    char **error)
+{
+    char specs[SERVER_LINE_SIZE];
+    char stars[SERVER_LINE_SIZE];
+    char moons_of[SERVER_LINE_SIZE];
+    char key[3 * SERVER_LINE_SIZE];
+    char *spec, *text;
+    int cacheable, i;
+
+    *seed = (unsigned)json_number(request, "seed", 0L);
+    *tripped = 0;
+    cacheable = (*seed != 0) && ((flag_cache_size > 0) || (flag_cache_dir != NULL));
+    if (json_string(request, "format", specs, sizeof(specs))
+        && (strcmp(specs, "text") != 0)) {
+        *error = "unknown format";
+        return(NULL);
+    }
+    flag_moons = (json_number(request, "moons", 0L) != 0);
+    /*
+     *  Any planets whose moons are wanted are built without the others':
+     */
+    moon_list_count = 0;
+    moons_of[0] = '\0';
+    if (json_string(request, "moons_of", specs, sizeof(specs))) {
+        if (!read_moon_list(specs)) {
+            *error = "bad list of planets";
+            return(NULL);
+        }
+        for (i = 0; i < moon_list_count; i++)
+            sprintf(moons_of + strlen(moons_of), "%s%ld", (i > 0) ? "," : "",
+                    moon_list[i]);
+    }
+    flag_lazy_moons = (moon_list_count > 0);
+    /*
+     *  The stars are given just as they would be with '-t'.  They are
+     *  also written out again in a standard form for the cache key:
+     */
+    stars[0] = '\0';
+    if (json_string(request, "stars", specs, sizeof(specs))) {
+        for (spec = strtok(specs, " ,"); spec != NULL; spec = strtok(NULL, " ,")) {
+            if (strlen(stars) + strlen(spec) + 2 > sizeof(stars)) {
+                *error = "too many stars";
+                return(NULL);
+            }
+            if (stars[0] != '\0')
+                strcat(stars, " ");
+            strcat(stars, spec);
+        }
+    }
+    /*
+     *  Any random system will do for a request giving neither a seed nor
+     *  stars, so one is taken from the pool if there's one ready:
+     */
+    if (*seed == 0) {
+        if ((stars[0] == '\0') && (moon_list_count == 0)
+            && ((text = pool_take(flag_moons, seed, length, tripped)) != NULL))
+            return(text);
+        *seed = random_seed();
+    }
+    if (cacheable) {
+        sprintf(key, "seed=%u stars=%s moons=%d moons_of=%s format=text ",
+                *seed, stars, flag_moons, moons_of);
+        write_parameters(key + strlen(key));
+        if (shown_fields != FIELD_ALL)
+            sprintf(key + strlen(key), " fields=%lx", shown_fields);
+        if ((text = cache_lookup(key, length)) != NULL)
+            return(text);
+    }
+    if (!read_star_list(stars, &star_specs)) {
+        *error = "bad star description";
+        return(NULL);
+    }
+    flag_startype = (star_specs != NULL);
+
+    text = capture_system(*seed, length);
+    *tripped = budget.tripped;
+
+    free_star_list(star_specs);
+    star_specs = NULL;
+    if (cacheable && (*tripped == 0))
+        cache_store(key, text, *length);
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Answer one request line with one reply line.  A request containing     */
+/*   "stats" is answered with the figures for this server process.          */
+/*--------------------------------------------------------------------------*/
+void serve_request(char *request, FILE *reply)
+{
+    char *text;
+    char *error;
+    unsigned seed;
+    long length;
+    int tripped;
+
+    if (json_number(request, "stats", 0L)) {
+        fprintf(reply, "{");
+#ifdef MULTIPROC
+        fprintf(reply, "\"pid\": %ld, ", (long)getpid());
+#endif
+        cache_report(reply);
+        fprintf(reply, ", ");
+        pool_report(reply);
+        fprintf(reply, "}\n");
+    }
+    else if ((text = build_request(request, &seed, &length, &tripped, &error)) == NULL) {
+        fprintf(reply, "{\"error\": ");
+        json_write_string(reply, error, (long)strlen(error));
+        fprintf(reply, "}\n");
+    }
+    else {
+        fprintf(reply, "{\"seed\": %u, \"format\": \"text\", ", seed);
+        if (tripped) {
+            fprintf(reply, "\"truncated\": \"%s\", ", budget_names(tripped));
+        }
+        fprintf(reply, "\"text\": ");
+        json_write_string(reply, text, length);
+        fprintf(reply, "}\n");
+        free(text);
+    }
+    fflush(reply);
+}
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   Wait until there's something to read on 'fd', spending the time        */
+/*   refilling the pool of ready-made systems.                              */
+/*--------------------------------------------------------------------------*/
+void wait_for_input(int fd)
+{
+    struct pollfd waiting;
+    int timeout;
+
+    for (;;) {
+        waiting.fd = fd;
+        waiting.events = POLLIN;
+        waiting.revents = 0;
+        timeout = pool_wait();
+        if (poll(&waiting, 1, timeout) > 0)
+            return;
+        if (pool_wait() == 0)
+            pool_refill();
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the next request line from 'fd' into 'line'.  The file is read    */
+/*   directly, rather than through stdio, so that its buffer can't hide a   */
+/*   waiting request from wait_for_input().  FALSE is returned once the     */
+/*   other end goes away.                                                   */
+/*--------------------------------------------------------------------------*/
+char request_buffer[SERVER_LINE_SIZE];
+int request_fill = 0;
+
+int read_request(int fd, char *line)
+{
+    char *end;
+    int length, done;
+
+    for (;;) {
+        if (((end = (char *)memchr(request_buffer, '\n', (size_t)request_fill)) != NULL)
+            || (request_fill == SERVER_LINE_SIZE - 1)) {
+            length = (end != NULL) ? (int)(end - request_buffer) + 1 : request_fill;
+            memcpy(line, request_buffer, (size_t)length);
+            line[length] = '\0';
+            request_fill -= length;
+            memmove(request_buffer, request_buffer + length, (size_t)request_fill);
+            return(TRUE);
+        }
+        wait_for_input(fd);
+        if ((done = (int)read(fd, request_buffer + request_fill,
+                              (size_t)(SERVER_LINE_SIZE - 1 - request_fill))) < 0) {
+            if (errno == EINTR)
+                continue;
+            return(FALSE);
+        }
+        if (done == 0) {
+            if (request_fill == 0)
+                return(FALSE);
+            memcpy(line, request_buffer, (size_t)request_fill);
+            line[request_fill] = '\0';
+            request_fill = 0;
+            return(TRUE);
+        }
+        request_fill += done;
+    }
+}
+
+#endif /* MULTIPROC */
+
+/*--------------------------------------------------------------------------*/
+/*   Answer requests until the other end goes away.                         */
+/*--------------------------------------------------------------------------*/
+void serve_stream(FILE *requests, FILE *reply)
+{
+    char line[SERVER_LINE_SIZE];
+
+#ifdef MULTIPROC
+    request_fill = 0;
+    while (read_request(fileno(requests), line)) {
+#else
+    while (fgets(line, sizeof(line), requests) != NULL) {
+#endif
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+        serve_request(line, reply);
+    }
+}
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   One member of the server's pool: accept connections on the shared      */
+/*   socket and answer them, one connection at a time.  The socket doesn't  */
+/*   block, so a worker that loses the race for a connection goes back to   */
+/*   refilling its pool rather than sitting in accept().                    */
+/*--------------------------------------------------------------------------*/
+void run_server_worker(int listener)
+{
+    FILE *requests, *reply;
+    int connection;
+
+    for (;;) {
+        wait_for_input(listener);
+        if ((connection = accept(listener, NULL, NULL)) < 0) {
+            if ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK))
+                continue;
+            perror("accepting a connection");
+            exit(1);
+        }
+        fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) & ~O_NONBLOCK);
+        if (((requests = fdopen(connection, "r")) == NULL)
+            || ((reply = fdopen(dup(connection), "w")) == NULL)) {
+            perror("opening a connection");
+            exit(1);
+        }
+        serve_stream(requests, reply);
+        fclose(reply);
+        fclose(requests);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Start a worker process for the server's pool.                          */
+/*--------------------------------------------------------------------------*/
+long start_server_worker(int listener)
+{
+    long pid;
+
+    if ((pid = (long)fork()) < 0) {
+        perror("forking a server process");
+        exit(1);
+    }
+    if (pid == 0) {
+        run_server_worker(listener);
+    }
+    return(pid);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Listen on the Unix-domain socket 'path'.  The pool of workers all      */
+/*   accept connections on it; this process just replaces any worker that   */
+/*   dies (a system that trips one of starform's internal errors exits).    */
+/*--------------------------------------------------------------------------*/
+void serve_socket(char *path)
+{
+    struct sockaddr_un address;
+    int listener;
+    int i, status;
+    long pid;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "ERROR: socket name <%s> is too long\n", path);
+        exit(1);
+    }
+    if ((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("creating the server socket");
+        exit(1);
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if ((bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0)
+        || (listen(listener, SERVER_BACKLOG) < 0)) {
+        perror(path);
+        exit(1);
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+    for (i = 0; i < flag_workers; i++) {
+        start_server_worker(listener);
+    }
+    for (;;) {
+        if ((pid = (long)wait(&status)) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("waiting for server processes");
+            exit(1);
+        }
+        fprintf(stderr, "Server process %ld died, starting another\n", pid);
+        start_server_worker(listener);
+    }
+}
+
+#endif /* MULTIPROC */
+
+/*--------------------------------------------------------------------------*/
+/*   Run as a server.  A 'path' of "-" (or none at all) serves requests on  */
+/*   standard input and output.  The replies then have standard output to   */
+/*   themselves: anything else the generator prints there (its progress     */
+/*   with -v, or its error messages) goes to the standard error instead.    */
+/*--------------------------------------------------------------------------*/
+void serve(char *path)
+{
+    FILE *replies;
+
+    open_pool(flag_moons);
+    if ((*path == '\0') || (strcmp(path, "-") == 0)) {
+        replies = stdout;
+#ifdef MULTIPROC
+        fflush(stdout);
+        if (((replies = fdopen(dup(STDOUT_FILENO), "w")) == NULL)
+            || (dup2(STDERR_FILENO, STDOUT_FILENO) < 0)) {
+            perror("setting aside standard output for the replies");
+            exit(1);
+        }
+#endif
+        serve_stream(stdin, replies);
+        fflush(replies);
+        return;
+    }
+#ifdef MULTIPROC
+    serve_socket(path);
+#else
+    fprintf(stderr, "ERROR: sockets aren't available here; use -L- instead\n");
+    exit(1);
+#endif
+}
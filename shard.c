@@ -0,0 +1,323 @@
+/*----------------------------------------------------------------------*/
+/*                               shard.c                                */
+/*                                                                      */
+/*  Splitting a batch between several runs, perhaps on several          */
+/*  machines, and putting the pieces back together.  With '-Hi/N' a     */
+/*  run makes only shard i of N of the batch: the systems whose place   */
+/*  in it leaves i over when divided by N, each with the same seed and  */
+/*  parameters it would have had in the whole batch.  Rather than text  */
+/*  it writes these out just as worker processes pass them back (see    */
+/*  batch.c), each with its place in the batch, followed by its census, */
+/*  ranking and sample in the same form.  '-J' then merges the shards:  */
+/*                                                                      */
+/*      starform -s42 -n100000 -a -H0/3 > part0                         */
+/*      starform -s42 -n100000 -a -H1/3 > part1                         */
+/*      starform -s42 -n100000 -a -H2/3 > part2                         */
+/*      starform -Jpart0 -Jpart1 -Jpart2 > batch                        */
+/*                                                                      */
+/*  Each shard holds its systems in the order of the batch, so the      */
+/*  merge only has to keep the next system of each shard in memory and  */
+/*  write out whichever comes first.  Censuses, rankings and samples    */
+/*  are merged just as the workers' are, so the result is the same as   */
+/*  if the whole batch had been made in one run.  Each shard notes the  */
+/*  flags that change its systems, so shards made with different ones   */
+/*  won't merge.  Shards are only meant to be merged by the same        */
+/*  starform on the same kind of machine.                               */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <fcntl.h>
+#include    <unistd.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern int flag_shard;
+extern int flag_shards;
+extern unsigned flag_seed;
+extern long flag_systems;
+extern char *flag_census;
+extern long flag_top;
+extern long flag_sample;
+extern char *flag_timing;
+extern char *flag_search;
+
+/*
+ *  The shards to be merged, and how far into the batch a shard has read
+ *  its manifest or catalog:
+ */
+char *shard_inputs[MAX_SHARD_INPUTS];
+int shard_input_count = 0;
+long next_shard_index = 0;
+
+/*
+ *  A hash of the flags that change the systems made (-p, -S, -m, -Q, -W
+ *  and so on), so that shards made with different ones aren't merged:
+ */
+unsigned long batch_settings = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Decode the '-H' flag, "i/N" for shard i (counting from 0) of N.        */
+/*   FALSE is returned if it can't be understood.                           */
+/*--------------------------------------------------------------------------*/
+int read_shard(char *spec)
+{
+    int offset;
+
+    offset = 0;
+    if ((sscanf(spec, "%d/%d%n", &flag_shard, &flag_shards, &offset) != 2)
+        || (spec[offset] != '\0') || (flag_shards < 1)
+        || (flag_shard < 0) || (flag_shard >= flag_shards)) {
+        fprintf(stderr, "ERROR: bad shard <%s>\n", spec);
+        return(FALSE);
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note a shard, named with '-J', to be merged.                           */
+/*--------------------------------------------------------------------------*/
+int add_shard_input(char *name)
+{
+    if (shard_input_count == MAX_SHARD_INPUTS)
+        return(FALSE);
+    shard_inputs[shard_input_count++] = name;
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note a flag that changes the systems made, such as "palpha=4.5", in    */
+/*   the hash of the batch's settings.                                      */
+/*--------------------------------------------------------------------------*/
+void note_setting(char *setting)
+{
+    batch_settings = (batch_settings * 31UL + cache_hash(setting)) & 0xFFFFFFFFUL;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The place among the systems of a shard of the system at 'index' in     */
+/*   the whole batch, or just 'index' if the batch isn't split up.          */
+/*--------------------------------------------------------------------------*/
+long shard_place(long index)
+{
+    if (flag_shards == 0)
+        return(index);
+    return(index / flag_shards);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Make up the task line for system 'place' of the shard, as              */
+/*   'next_task_line' does for the whole batch.  The systems of other       */
+/*   shards in between are skipped over, so that those read from a          */
+/*   manifest or catalog are the same as in the whole batch.                */
+/*--------------------------------------------------------------------------*/
+int next_shard_line(long place, unsigned seed, char *task)
+{
+    long index;
+
+    if (flag_shards == 0)
+        return(next_task_line(place, seed, task));
+    index = place * flag_shards + flag_shard;
+    while (next_shard_index < index) {
+        if (!next_task_line(next_shard_index++, seed, task))
+            return(FALSE);
+    }
+    next_shard_index++;
+    return(next_task_line(index, seed, task));
+}
+
+#ifdef MULTIPROC
+
+/*--------------------------------------------------------------------------*/
+/*   Start the output of a shard with a record saying which shard it is and */
+/*   which batch it comes from, so that it can be checked against the       */
+/*   others when they are merged.                                           */
+/*--------------------------------------------------------------------------*/
+void start_shard(void)
+{
+    char line[SNAPSHOT_LINE_SIZE];
+
+    sprintf(line, "%d %d %u %ld %d %ld %ld %d %d %08lx", flag_shard, flag_shards,
+            flag_seed, flag_systems, (flag_census != NULL), flag_top, flag_sample,
+            (flag_timing != NULL), (flag_search != NULL), batch_settings);
+    send_record(-1, RECORD_SHARD, line, (long)strlen(line));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out a finished system: just its text, or in a shard the header   */
+/*   it came back with as well.                                             */
+/*--------------------------------------------------------------------------*/
+void emit_system(record_header *header, char *text)
+{
+    if (flag_shards > 0)
+        emit_record((char *)header, (long)sizeof(record_header));
+    emit_record(text, header->length);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Finish the output of a shard: a record to end its systems, then its    */
+/*   census, ranking and sample.                                            */
+/*--------------------------------------------------------------------------*/
+void end_shard(void)
+{
+    send_record(-1, RECORD_END, "", 0L);
+    send_summaries(-1);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the first record of a shard, and check that it is one of the      */
+/*   same batch as the first shard read.  Its number is returned.           */
+/*--------------------------------------------------------------------------*/
+int open_shard(worker_info *shard, char *name, char *batch)
+{
+    record_header header;
+    char line[SNAPSHOT_LINE_SIZE];
+    int which, shards, offset;
+
+    if ((shard->result_fd = open(name, O_RDONLY)) < 0) {
+        perror(name);
+        exit(1);
+    }
+    shard->in_flight = 0;
+    if (!read_full(shard->result_fd, (char *)&header, (long)sizeof(header))
+        || (header.index != RECORD_SHARD)
+        || (header.length < 0) || (header.length >= SNAPSHOT_LINE_SIZE)
+        || !read_full(shard->result_fd, line, header.length)) {
+        fprintf(stderr, "ERROR: <%s> isn't a shard\n", name);
+        exit(1);
+    }
+    line[header.length] = '\0';
+    offset = 0;
+    if ((sscanf(line, "%d %d %n", &which, &shards, &offset) != 2) || (offset == 0)) {
+        fprintf(stderr, "ERROR: <%s> isn't a shard\n", name);
+        exit(1);
+    }
+    if (batch[0] == '\0') {
+        strcpy(batch, line + offset);
+        flag_shards = shards;
+    }
+    else if ((shards != flag_shards) || (strcmp(batch, line + offset) != 0)) {
+        fprintf(stderr, "ERROR: <%s> is a shard of a different batch\n", name);
+        exit(1);
+    }
+    return(which);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Merge the shards given with '-J' and write out the whole batch.  Each  */
+/*   shard must be given once.  With '-a<file>' the merged census is saved  */
+/*   as well, and with '-I' saved censuses are added to it.                 */
+/*--------------------------------------------------------------------------*/
+void merge_shards(void)
+{
+    worker_info *shards;
+    record_header *heads;
+    char **texts;
+    char *given;
+    char batch[SNAPSHOT_LINE_SIZE];
+    char line[SNAPSHOT_LINE_SIZE];
+    int i, which, best, census, timed, searched;
+
+    if (((shards = (worker_info *)malloc(shard_input_count * sizeof(worker_info))) == NULL)
+        || ((heads = (record_header *)malloc(shard_input_count
+                                             * sizeof(record_header))) == NULL)
+        || ((texts = (char **)malloc(shard_input_count * sizeof(char *))) == NULL)
+        || ((given = (char *)calloc((size_t)shard_input_count, 1)) == NULL)) {
+        perror("malloc'ing the shards");
+        exit(1);
+    }
+    batch[0] = '\0';
+    for (i = 0; i < shard_input_count; i++) {
+        shards[i].pid = i;
+        which = open_shard(&shards[i], shard_inputs[i], batch);
+        if ((flag_shards != shard_input_count)
+            || (which < 0) || (which >= flag_shards) || given[which]) {
+            fprintf(stderr, "ERROR: each of the %d shards of the batch must be "
+                            "given once\n", flag_shards);
+            exit(1);
+        }
+        given[which] = TRUE;
+    }
+    timed = searched = FALSE;
+    sscanf(batch, "%*u %*d %d %ld %ld %d %d", &census, &flag_top, &flag_sample,
+           &timed, &searched);
+    if ((flag_census != NULL) && !census) {
+        fprintf(stderr, "ERROR: the shards weren't counted (-a)\n");
+        exit(1);
+    }
+    if (census && (flag_census == NULL))
+        flag_census = "";
+    if ((flag_timing != NULL) && !timed) {
+        fprintf(stderr, "ERROR: the shards weren't timed (-i)\n");
+        exit(1);
+    }
+    if (timed && (flag_timing == NULL))
+        flag_timing = "";
+    if (searched)
+        flag_search = "";
+
+    open_output();
+    sprintf(line, "Starform - V%s\n", VERSION);
+    emit_record(line, (long)strlen(line));
+    for (i = 0; i < shard_input_count; i++)
+        texts[i] = read_record(&shards[i], &heads[i]);
+    for (;;) {
+        /*
+         *  Write out whichever shard's next system comes first:
+         */
+        best = -1;
+        for (i = 0; i < shard_input_count; i++) {
+            if ((heads[i].index >= 0)
+                && ((best < 0) || (heads[i].index < heads[best].index)))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        emit_record(texts[best], heads[best].length);
+        note_truncation(heads[best].tripped);
+        note_search(heads[best].rejected);
+        free(texts[best]);
+        texts[best] = read_record(&shards[best], &heads[best]);
+    }
+    for (i = 0; i < shard_input_count; i++) {
+        if (heads[i].index != RECORD_END) {
+            fprintf(stderr, "ERROR: shard <%s> is damaged\n", shard_inputs[i]);
+            exit(1);
+        }
+        free(texts[i]);
+    }
+    if ((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0)
+        || (flag_timing != NULL))
+        collect_summaries(shards, shard_input_count);
+    if ((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0))
+        write_summaries();
+    close_output();
+    report_truncation();
+    report_search();
+    report_timing();
+    for (i = 0; i < shard_input_count; i++)
+        close(shards[i].result_fd);
+    free(given);
+    free(texts);
+    free(heads);
+    free(shards);
+}
+
+#else /* MULTIPROC */
+
+void merge_shards(void)
+{
+    fprintf(stderr, "ERROR: -J is only available where starform can fork\n");
+    exit(1);
+}
+
+#endif /* MULTIPROC */
@@ -0,0 +1,319 @@
+/*----------------------------------------------------------------------*/
+/*                              snapshot.c                              */
+/*                                                                      */
+/*  Snapshots of systems whose accretion is over but whose planets      */
+/*  haven't yet been finished (the -A and -E flags).  Accretion takes   */
+/*  most of the time spent on a system, while the environment of each   */
+/*  planet (its radius, day, atmosphere, temperature and so on) takes   */
+/*  little, so a catalog of snapshots can be made once with '-A' and    */
+/*  the environment worked out again over it with '-E' each time that   */
+/*  part of the model is changed.  A system finished from its snapshot  */
+/*  is just the one its seed gives, as long as the model is the same.   */
+/*                                                                      */
+/*  A snapshot is a few lines of text, such as:                         */
+/*                                                                      */
+/*      system 1 1                                                      */
+/*      budget 9 61 0 0                                                 */
+/*      params dust_density_coeff=0.0060000000000000001 alpha=5 ...     */
+/*      star 4 0 2823922363.9592166 0.65968800669521466 ... K6 V        */
+/*      planet 0 0 0.0067161414191829749 0.65968800669521466 0          */
+/*      planet 1 0.27105538999374079 0.14544089936691362 ... -1         */
+/*      ...                                                             */
+/*      end                                                             */
+/*                                                                      */
+/*  giving the seed and whether there are to be moons; the work done    */
+/*  so far (see step.c); the parameters the system was made with (and   */
+/*  its weight, if its primary was chosen by weight with -W); and then  */
+/*  its stars, and its planets (the stars among them) in order.         */
+/*  Lines outside 'system' and 'end' are ignored, so a catalog can be   */
+/*  kept with other text.  The planets draw their random numbers from   */
+/*  streams of their own (see utils.c), which start afresh from the     */
+/*  seed, so nothing more is needed to finish them just as before.      */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern int flag_moons;
+extern char *flag_replay;
+extern work_budget budget;
+extern parameter_info parameter_table[];
+extern char system_tag[];
+extern FILE *display_file;
+extern double system_weight;
+extern int system_weighted;
+
+/*
+ *  The catalog of snapshots being finished, and whether 'sys' holds a
+ *  system read back from one rather than one still to be generated:
+ */
+FILE *catalog = NULL;
+int snapshot_loaded = FALSE;
+
+/*--------------------------------------------------------------------------*/
+/*   Generate the system for one seed as far as the end of accretion, and   */
+/*   write out its snapshot in place of its description.                    */
+/*--------------------------------------------------------------------------*/
+void make_snapshot(unsigned seed)
+{
+    gen_context context;
+
+    seed_random(seed);
+    start_generation(&context);
+    context.last_stage = STAGE_ACCRETION;
+    while (generate_step(&context, 0L, 0L) != GEN_DONE)
+        ;
+    write_snapshot(display_file, seed);
+    free_system(&sys);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Write out the snapshot of the system in 'sys'.  The numbers are given  */
+/*   to full precision, so that they read back exactly as they were.        */
+/*--------------------------------------------------------------------------*/
+void write_snapshot(FILE *fp, unsigned seed)
+{
+    parameter_info *param;
+    star_pointer star;
+    planet_pointer planet;
+    int star_number;
+
+    fprintf(fp, "system %u %d\n", seed, flag_moons ? 1 : 0);
+    fprintf(fp, "budget %ld %ld %ld %d\n", budget.injections, budget.sweeps,
+            budget.msec, budget.tripped);
+    fprintf(fp, "params");
+    for (param = parameter_table; param->name != NULL; param++)
+        fprintf(fp, " %s=%.17g", param->name, *param->value);
+    fprintf(fp, "\n");
+    if (system_tag[0] != '\0')
+        fprintf(fp, "tag %s\n", system_tag);
+    if (system_weighted)
+        fprintf(fp, "weight %.17g\n", system_weight);
+    for (star = sys.primary_star; star != NULL; star = star->next_star) {
+        fprintf(fp, "star %d %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %s\n",
+                star->lum_type, star->orbit_radius, star->age,
+                star->stell_mass_ratio, star->stell_luminosity_ratio,
+                star->stell_radius, star->main_seq_life, star->r_ecosphere,
+                star->r_greenhouse, star->star_type);
+    }
+    for (planet = sys.inner_planet; planet != NULL; planet = planet->next_planet) {
+        star_number = -1;
+        if (planet->mass_type == STAR) {
+            for (star = sys.primary_star, star_number = 0;
+                 star != planet->star_ptr;
+                 star = star->next_star)
+                star_number++;
+        }
+        fprintf(fp, "planet %d %.17g %.17g %.17g %d\n", planet->mass_type,
+                planet->a, planet->e, planet->mass, star_number);
+    }
+    fprintf(fp, "end\n");
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Open the catalog named with '-E' ("-" is standard input).              */
+/*--------------------------------------------------------------------------*/
+void open_catalog(void)
+{
+    if (flag_replay == NULL)
+        return;
+    if ((*flag_replay == '\0') || (strcmp(flag_replay, "-") == 0))
+        catalog = stdin;
+    else if ((catalog = fopen(flag_replay, "r")) == NULL) {
+        perror(flag_replay);
+        exit(1);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Copy the next snapshot in 'fp', from its 'system' line to its 'end'    */
+/*   line, into 'buf' (which holds 'size' bytes).  FALSE is returned once   */
+/*   there are no more.  A snapshot too big for 'buf' is reported and       */
+/*   skipped.                                                               */
+/*--------------------------------------------------------------------------*/
+int read_snapshot_text(FILE *fp, char *buf, long size)
+{
+    char line[SNAPSHOT_LINE_SIZE];
+    long used;
+    int fits;
+
+    do {
+        if (fgets(line, sizeof(line), fp) == NULL)
+            return(FALSE);
+    } while (strncmp(line, "system ", 7) != 0);
+    used = 0;
+    fits = TRUE;
+    for (;;) {
+        if (used + (long)strlen(line) < size) {
+            strcpy(buf + used, line);
+            used += (long)strlen(line);
+        }
+        else fits = FALSE;
+        if (strncmp(line, "end", 3) == 0)
+            break;
+        if (fgets(line, sizeof(line), fp) == NULL) {
+            fprintf(stderr, "ERROR: the last snapshot has no end\n");
+            return(FALSE);
+        }
+    }
+    if (!fits) {
+        fprintf(stderr, "ERROR: snapshot <%.*s> is too big\n",
+                (int)strcspn(buf, "\n"), buf);
+        return(read_snapshot_text(fp, buf, size));
+    }
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read one line of a snapshot into the system in 'sys'.  'tail' is       */
+/*   where the next planet goes.  FALSE is returned if the line makes no    */
+/*   sense.                                                                 */
+/*--------------------------------------------------------------------------*/
+int load_snapshot_line(char *line, planet_pointer **tail)
+{
+    star_pointer star, *star_tail;
+    planet_pointer planet;
+    parameter_info *param;
+    char *word, *equals;
+    int star_number, offset;
+
+    if (strncmp(line, "budget ", 7) == 0) {
+        return(sscanf(line + 7, "%ld %ld %ld %d", &budget.injections,
+                      &budget.sweeps, &budget.msec, &budget.tripped) == 4);
+    }
+    if (strncmp(line, "params ", 7) == 0) {
+        /*
+         *  Parameters given with -p on this run take precedence:
+         */
+        for (word = strtok(line + 7, " "); word != NULL; word = strtok(NULL, " ")) {
+            if (((equals = strchr(word, '=')) == NULL)
+                || ((param = find_parameter(word, (int)(equals - word))) == NULL))
+                return(FALSE);
+            if (!param->given && !set_parameter(word))
+                return(FALSE);
+        }
+        return(TRUE);
+    }
+    if (strncmp(line, "tag ", 4) == 0) {
+        if (strlen(line + 4) >= TASK_LINE_SIZE)
+            return(FALSE);
+        strcpy(system_tag, line + 4);
+        return(TRUE);
+    }
+    if (strncmp(line, "weight ", 7) == 0) {
+        system_weighted = TRUE;
+        return(sscanf(line + 7, "%lf", &system_weight) == 1);
+    }
+    if (strncmp(line, "star ", 5) == 0) {
+        if ((star = (stars *)calloc(1, sizeof(stars))) == NULL) {
+            perror("malloc'ing memory for a star");
+            exit(1);
+        }
+        for (star_tail = &sys.primary_star; *star_tail != NULL;
+             star_tail = &(*star_tail)->next_star)
+            ;
+        *star_tail = star;
+        offset = 0;
+        if ((sscanf(line + 5, "%d %lf %lf %lf %lf %lf %lf %lf %lf %n",
+                    &star->lum_type, &star->orbit_radius, &star->age,
+                    &star->stell_mass_ratio, &star->stell_luminosity_ratio,
+                    &star->stell_radius, &star->main_seq_life,
+                    &star->r_ecosphere, &star->r_greenhouse, &offset) != 9)
+            || (offset == 0) || (strlen(line + 5 + offset) >= CLASSIFICATION_SIZE))
+            return(FALSE);
+        strcpy(star->star_type, line + 5 + offset);
+        return(TRUE);
+    }
+    if (strncmp(line, "planet ", 7) == 0) {
+        if ((planet = (planets *)calloc(1, sizeof(planets))) == NULL) {
+            perror("malloc'ing a new planet");
+            exit(1);
+        }
+        **tail = planet;
+        *tail = &planet->next_planet;
+        if (sscanf(line + 7, "%d %lf %lf %lf %d", &planet->mass_type,
+                   &planet->a, &planet->e, &planet->mass, &star_number) != 5)
+            return(FALSE);
+        if (planet->mass_type == STAR) {
+            for (star = sys.primary_star; (star != NULL) && (star_number > 0);
+                 star = star->next_star)
+                star_number--;
+            if ((star == NULL) || (star_number < 0))
+                return(FALSE);
+            planet->star_ptr = star;
+            star->planet_ptr = planet;
+        }
+        return(TRUE);
+    }
+    return(FALSE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read a snapshot (as copied by 'read_snapshot_text') back into 'sys',   */
+/*   ready for 'make_system' to finish, and return its seed in 'seed'.      */
+/*   Its parameters, and whether it has moons, are set for the system.      */
+/*   FALSE is returned (after saying why) if the snapshot makes no sense.   */
+/*--------------------------------------------------------------------------*/
+int load_snapshot(char *text, unsigned *seed)
+{
+    planet_pointer *tail;
+    char *line, *next;
+    int moons;
+
+    sys.primary_star = NULL;
+    sys.inner_planet = NULL;
+    tail = &sys.inner_planet;
+    system_tag[0] = '\0';
+    system_weight = 1.0;
+    system_weighted = FALSE;
+    budget.injections = 0;
+    budget.sweeps = 0;
+    budget.msec = 0;
+    budget.tripped = 0;
+    if (sscanf(text, "system %u %d", seed, &moons) != 2) {
+        fprintf(stderr, "ERROR: bad snapshot <%.*s>\n", (int)strcspn(text, "\n"), text);
+        return(FALSE);
+    }
+    line = strchr(text, '\n') + 1;
+    for (; strncmp(line, "end", 3) != 0; line = next + 1) {
+        next = strchr(line, '\n');
+        *next = '\0';
+        if (!load_snapshot_line(line, &tail)) {
+            fprintf(stderr, "ERROR: bad line <%s> in the snapshot of system %u\n",
+                    line, *seed);
+            free_system(&sys);
+            system_tag[0] = '\0';
+            return(FALSE);
+        }
+    }
+    if ((sys.primary_star == NULL) || (sys.primary_star->planet_ptr == NULL)) {
+        fprintf(stderr, "ERROR: the snapshot of system %u has no primary\n", *seed);
+        free_system(&sys);
+        return(FALSE);
+    }
+    flag_moons = moons;
+    seed_random(*seed);
+    snapshot_loaded = TRUE;
+    return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Finish the planets of the system read back from a snapshot.            */
+/*--------------------------------------------------------------------------*/
+void finish_snapshot(void)
+{
+    gen_context context;
+
+    resume_generation(&context);
+    while (generate_step(&context, 0L, 0L) != GEN_DONE)
+        ;
+    snapshot_loaded = FALSE;
+}
@@ -29,6 +29,10 @@
  */
 star_system sys;
 int resonance;
+extern unsigned long random_state;
+extern work_budget budget;
+extern int census_input_count;
+extern int shard_input_count;
 
 
 /*
@@ -40,6 +44,55 @@ int flag_graphic =      FALSE;
 int flag_moons =        FALSE;
 int flag_startype =     FALSE;
 int flag_tec =          FALSE;  /* for Dave Allen's "tec" program */
+long flag_systems =     1;      /* number of systems to generate    */
+int flag_workers =      1;      /* number of generator processes    */
+long flag_window =      0;      /* systems held for ordered output  */
+int flag_unordered =    FALSE;  /* write systems as they finish     */
+int flag_compress =     FALSE;  /* compress batch output            */
+char *flag_listen =     NULL;   /* run as a server on this socket   */
+long flag_cache_size =  0;      /* bytes of systems the server keeps */
+char *flag_cache_dir =  NULL;   /* where the server keeps systems   */
+long flag_pool_size =   0;      /* random systems kept ready        */
+int flag_pool_budget =  50;     /* percent of CPU spent filling pool */
+long flag_max_injections = 0;   /* most protoplanets per system     */
+long flag_max_sweeps =  0;      /* most dust sweeps per system      */
+long flag_max_msec =    0;      /* most time per system, in ms      */
+char *flag_manifest =   NULL;   /* file listing the systems to make */
+char *flag_sweep =      NULL;   /* parameter points to make them at */
+int flag_snapshot =     FALSE;  /* stop each system after accretion */
+int flag_lazy_moons =   FALSE;  /* build moons when they're wanted  */
+int flag_moon_workers = 1;      /* processes building one system's moons */
+char *flag_replay =     NULL;   /* catalog of snapshots to finish   */
+char *flag_search =     NULL;   /* conditions the systems must meet */
+char *flag_census =     NULL;   /* count the systems, not show them */
+long flag_top =         0;      /* most Earth-like planets listed   */
+long flag_sample =      0;      /* systems sampled of each kind     */
+int flag_shard =        0;      /* which shard of the batch to make */
+int flag_shards =       0;      /* ... of how many, if it's split   */
+char *flag_journal =    NULL;   /* where to note how far it's got   */
+int flag_resume =       FALSE;  /* carry on from there              */
+char *flag_quarantine = NULL;   /* where to note systems that crash */
+char *flag_timing =     NULL;   /* time each stage of each system   */
+long flag_hang_limit =  0;      /* most seconds a system may take   */
+
+/*
+ *    The stars given with '-t' on the command line.  A fresh copy of
+ *    this list is made for every system generated:
+ */
+star_pointer star_specs = NULL;
+
+/*
+ *    The planets whose moons are wanted, given with '-M' (with '-m', all
+ *    of them are):
+ */
+long moon_list[MAX_MOON_LIST];
+int moon_list_count = 0;
+
+extern FILE *display_file;
+extern int target_count;
+extern int star_weight_count;
+extern double system_weight;
+extern int system_weighted;
 
 /*--------------------------------------------------------------------------*/
 /*   The main function decodes all of the command-line parameters, then     */
@@ -53,9 +106,7 @@ int main (int argc, char *argv[])
 {
     char *c, *progname;
     int skip;
-    int errornum;
-    int radius;
-    star_pointer *star = &sys.primary_star;
+    star_pointer *star = &star_specs;
 
 /*
  *    Grab all the command-line parameters:
@@ -72,6 +123,7 @@ int main (int argc, char *argv[])
                 ++flag_graphic;
                 break;
             case 'm':    /* generate moons for planets */
+                note_setting("m");
                 ++flag_moons;
                 break;
             case 's':    /* set random seed */
@@ -86,53 +138,205 @@ int main (int argc, char *argv[])
                 ++flag_tec;
                 break;
             case 't': /* specify star type */
+                note_setting(c);
                 ++flag_startype;
-                /*
-                 *  Allocate memory for the new star in the linked list:
-                 */
-                if ((*star = (stars *)malloc((unsigned)sizeof(stars))) == NULL) {
-                    perror("malloc'ing memory for a star");
-                    exit(1);
+                if ((*star = read_startype(++c)) == NULL) {
+                    usage(progname);
                 }
-                (*star)->next_star = NULL;
-                /*
-                 *  Figure out stellar class and luminosity information:
-                 */
-                if (sscanf(++c, "%c%d%c/%d", &(*star)->spec_class,
-                                      &(*star)->spec_num,
-                                      &(*star)->lum_id,
-                                      &radius) != 4) {
+                skip = TRUE;
+                star = &((*star)->next_star);
+                break;
+            case 'n':    /* number of systems to generate */
+                flag_systems = atol(&(*++c));
+                if (flag_systems < 0) {
                     usage(progname);
                 }
-                (*star)->orbit_radius = (double)radius;
-                if ((errornum = verify_startype((*star)->lum_id,
-                                                (*star)->spec_num,
-                                                (*star)->spec_class)) != 0) {
-                    startype_error(errornum, (*star)->spec_class,
-                                              (*star)->spec_num,
-                                             (*star)->lum_id);
+                skip = TRUE;
+                break;
+            case 'j':    /* number of generator processes */
+                flag_workers = atoi(&(*++c));
+                if (flag_workers < 1) {
+                    usage(progname);
+                }
+                skip = TRUE;
+                break;
+            case 'w':    /* size of the reorder window */
+                flag_window = atol(&(*++c));
+                if (flag_window < 1) {
                     usage(progname);
                 }
-                /*
-                 *  Translate the command-line 'lum_id' into a 'lum_type':
-                 */
-                switch ((*star)->lum_id) {
-                    case 'S':
-                        (*star)->lum_type = SUPERGIANT;
+                skip = TRUE;
+                break;
+            case 'u':    /* write systems in the order they finish */
+                ++flag_unordered;
+                break;
+            case 'z':    /* compress the output */
+                ++flag_compress;
+                break;
+            case 'L':    /* run as a server */
+                flag_listen = ++c;
+                skip = TRUE;
+                break;
+            case 'C':    /* size of the server's cache, in K */
+                flag_cache_size = atol(&(*++c)) * 1024L;
+                skip = TRUE;
+                break;
+            case 'D':    /* directory for the server's cache */
+                flag_cache_dir = ++c;
+                skip = TRUE;
+                break;
+            case 'b':    /* a budget of work for each system */
+                note_setting(c);
+                switch (*++c) {
+                    case 'i':
+                        flag_max_injections = atol(&(*++c));
                         break;
-                    case 'G':
-                        (*star)->lum_type = GIANT;
+                    case 's':
+                        flag_max_sweeps = atol(&(*++c));
                         break;
-                    case 'D':
-                        (*star)->lum_type = WHITE_DWARF;
+                    case 't':
+                        flag_max_msec = atol(&(*++c));
                         break;
-                    case 'M':
                     default:
-                        (*star)->lum_type = MAIN_SEQUENCE;
-                        break;
+                        usage(progname);
+                }
+                skip = TRUE;
+                break;
+            case 'f':    /* read the systems to make from a manifest */
+                flag_manifest = ++c;
+                skip = TRUE;
+                break;
+            case 'p':    /* set a physical parameter */
+                note_setting(c);
+                if (!give_parameter(++c)) {
+                    fprintf(stderr, "ERROR: bad parameter setting <%s>\n", c);
+                    exit(1);
+                }
+                skip = TRUE;
+                break;
+            case 'S':    /* sweep through values of the parameters */
+                note_setting(c);
+                flag_sweep = ++c;
+                if (!read_sweep(c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'M':    /* build moons only for the planets wanted */
+                note_setting(c);
+                ++flag_lazy_moons;
+                if (!read_moon_list(++c)) {
+                    fprintf(stderr, "ERROR: bad list of planets <%s>\n", c);
+                    exit(1);
+                }
+                skip = TRUE;
+                break;
+            case 'K':    /* number of processes building moons */
+                flag_moon_workers = atoi(&(*++c));
+                if (flag_moon_workers < 1) {
+                    usage(progname);
+                }
+                skip = TRUE;
+                break;
+            case 'F':    /* work out and show only these fields */
+                note_setting(c);
+                if (!read_fields(++c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'Q':    /* write only the systems meeting these conditions */
+                note_setting(c);
+                flag_search = ++c;
+                if (!read_search(c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'a':    /* write a census of the systems */
+                flag_census = ++c;
+                skip = TRUE;
+                break;
+            case 'k':    /* list the most Earth-like planets */
+                flag_top = atol(&(*++c));
+                if (flag_top < 1) {
+                    usage(progname);
+                }
+                start_ranking();
+                skip = TRUE;
+                break;
+            case 'r':    /* write only a random sample of the systems */
+                if (!read_sample(++c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'c':    /* stop once these statistics are known */
+                if (!read_targets(++c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'W':    /* make some kinds of primary more often */
+                note_setting(c);
+                if (!read_star_weights(++c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'H':    /* make only one shard of the batch */
+                if (!read_shard(++c))
+                    exit(1);
+                skip = TRUE;
+                break;
+            case 'J':    /* merge the shards of a batch */
+                if (!add_shard_input(++c)) {
+                    fprintf(stderr, "ERROR: too many shards given with -J\n");
+                    exit(1);
+                }
+                skip = TRUE;
+                break;
+            case 'l':    /* keep a journal of how far the batch has got */
+                flag_journal = ++c;
+                skip = TRUE;
+                break;
+            case 'R':    /* carry on the batch in the journal */
+                ++flag_resume;
+                break;
+            case 'q':    /* carry on past systems that crash */
+                flag_quarantine = ++c;
+                skip = TRUE;
+                break;
+            case 'x':    /* kill systems that take too long */
+                flag_hang_limit = atol(&(*++c));
+                if (flag_hang_limit < 1) {
+                    usage(progname);
+                }
+                skip = TRUE;
+                break;
+            case 'i':    /* time each stage of making the systems */
+                flag_timing = ++c;
+                skip = TRUE;
+                break;
+            case 'I':    /* add a saved census to this one */
+                if (!add_census_input(++c)) {
+                    fprintf(stderr, "ERROR: too many censuses given with -I\n");
+                    exit(1);
+                }
+                skip = TRUE;
+                break;
+            case 'A':    /* write snapshots after accretion */
+                ++flag_snapshot;
+                break;
+            case 'E':    /* finish the systems in a catalog of snapshots */
+                flag_replay = ++c;
+                skip = TRUE;
+                break;
+            case 'P':    /* size of the server's pool of random systems */
+                flag_pool_size = atol(&(*++c));
+                skip = TRUE;
+                break;
+            case 'B':    /* CPU budget for refilling the pool */
+                flag_pool_budget = atoi(&(*++c));
+                if ((flag_pool_budget < 1) || (flag_pool_budget > 100)) {
+                    fprintf(stderr, "ERROR: -B needs a percentage from 1 to 100\n");
+                    exit(1);
                 }
                 skip = TRUE;
-                star = &((*star)->next_star);
                 break;
             default:
             case '?':
@@ -142,9 +346,163 @@ int main (int argc, char *argv[])
 /*
  *    Now do all the hard work:
  */
-    init();
-    generate_stellar_system();
-    display_system(&sys);
+    display_file = stdout;
+    if ((flag_search != NULL) && ((flag_listen != NULL) || flag_snapshot)) {
+        fprintf(stderr, "ERROR: a search (-Q) can't be used with -L or -A\n");
+        exit(1);
+    }
+    if (((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0))
+        && ((flag_listen != NULL) || flag_snapshot)) {
+        fprintf(stderr, "ERROR: a census (-a), ranking (-k) or sample (-r) can't "
+                        "be used with -L or -A\n");
+        exit(1);
+    }
+    if ((target_count > 0) && ((flag_listen != NULL) || flag_snapshot || (flag_systems < 2))) {
+        fprintf(stderr, "ERROR: a run to convergence (-c) needs the most systems "
+                        "to make (-n), and can't be used with -L or -A\n");
+        exit(1);
+    }
+    if ((target_count > 0) && ((flag_census != NULL) || (flag_top > 0) || (flag_sample > 0))) {
+        fprintf(stderr, "ERROR: a run to convergence (-c) can't be used with -a, -k or -r\n");
+        exit(1);
+    }
+    if ((star_weight_count > 0) && (flag_startype || (flag_listen != NULL))) {
+        fprintf(stderr, "ERROR: weighted primaries (-W) can't be used with -t or -L\n");
+        exit(1);
+    }
+    if ((flag_shards > 0)
+        && (flag_unordered || flag_compress || (target_count > 0) || (flag_listen != NULL)
+            || (census_input_count > 0) || ((flag_census != NULL) && (*flag_census != '\0')))) {
+        fprintf(stderr, "ERROR: a shard (-H) can't be used with -u, -z, -c, -L or -I, "
+                        "or save its census (the merge can)\n");
+        exit(1);
+    }
+    if ((flag_shards > 0) && !flag_seed && (flag_manifest == NULL) && (flag_replay == NULL)) {
+        fprintf(stderr, "ERROR: the shards of a batch must all be given its seed (-s)\n");
+        exit(1);
+    }
+    if ((flag_journal != NULL)
+        && (flag_unordered || (target_count > 0) || (flag_listen != NULL)
+            || (flag_census != NULL) || (flag_top > 0) || (flag_sample > 0))) {
+        fprintf(stderr, "ERROR: a journal (-l) can't be kept with -u, -c, -L, -a, -k or -r\n");
+        exit(1);
+    }
+    if ((flag_quarantine != NULL)
+        && ((flag_listen != NULL) || (flag_census != NULL) || (flag_top > 0)
+            || (flag_sample > 0))) {
+        fprintf(stderr, "ERROR: a supervised batch (-q) can't be used with -L, -a, -k or -r\n");
+        exit(1);
+    }
+    if ((flag_timing != NULL) && (flag_listen != NULL)) {
+        fprintf(stderr, "ERROR: timing (-i) can't be used with -L\n");
+        exit(1);
+    }
+    if ((flag_hang_limit > 0) && (flag_quarantine == NULL)) {
+        fprintf(stderr, "ERROR: killing hung systems (-x) needs a quarantine file (-q)\n");
+        exit(1);
+    }
+    if (flag_resume && (flag_journal == NULL)) {
+        fprintf(stderr, "ERROR: carrying on a batch (-R) needs its journal (-l)\n");
+        exit(1);
+    }
+    if (shard_input_count > 0) {
+        merge_shards();
+        exit(0);
+    }
+    if ((census_input_count > 0) && (flag_census == NULL)) {
+        fprintf(stderr, "ERROR: saved censuses (-I) can only be added to a census (-a)\n");
+        exit(1);
+    }
+    if ((flag_systems == 0) && (census_input_count == 0)) {
+        usage(progname);
+    }
+    if (flag_listen != NULL) {
+        serve(flag_listen);
+    }
+    else if ((flag_manifest != NULL) && (flag_sweep != NULL)) {
+        fprintf(stderr, "ERROR: a manifest (-f) can't be swept (-S)\n");
+        exit(1);
+    }
+    else if ((flag_replay != NULL)
+             && (flag_snapshot || (flag_manifest != NULL) || (flag_sweep != NULL))) {
+        fprintf(stderr, "ERROR: a catalog (-E) can't be used with -A, -f or -S\n");
+        exit(1);
+    }
+    else if ((flag_systems > 1) || (flag_workers > 1) || flag_compress
+             || (flag_manifest != NULL) || (flag_sweep != NULL)
+             || flag_snapshot || (flag_replay != NULL) || (flag_search != NULL)
+             || (flag_census != NULL) || (flag_top > 0) || (flag_sample > 0)
+             || (target_count > 0) || (star_weight_count > 0) || (flag_shards > 0)
+             || (flag_journal != NULL) || (flag_quarantine != NULL)
+             || (flag_timing != NULL)) {
+        generate_batch();
+    }
+    else {
+        init();
+        generate_stellar_system();
+        display_system(&sys);
+    }
+    exit(0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Decode one star description of the form used by the '-t' flag         */
+/*   ("G2M/0", for instance) into a newly allocated star.  NULL is          */
+/*   returned if the description can't be understood.                       */
+/*--------------------------------------------------------------------------*/
+star_pointer read_startype (char *spec)
+{
+    star_pointer star;
+    int errornum;
+    int radius;
+
+    /*
+     *  Allocate memory for the new star in the linked list:
+     */
+    if ((star = (stars *)malloc((unsigned)sizeof(stars))) == NULL) {
+        perror("malloc'ing memory for a star");
+        exit(1);
+    }
+    star->next_star = NULL;
+    /*
+     *  Figure out stellar class and luminosity information:
+     */
+    if (sscanf(spec, "%c%d%c/%d", &star->spec_class,
+                                  &star->spec_num,
+                                  &star->lum_id,
+                                  &radius) != 4) {
+        free(star);
+        return(NULL);
+    }
+    star->orbit_radius = (double)radius;
+    if ((errornum = verify_startype(star->lum_id,
+                                    star->spec_num,
+                                    star->spec_class)) != 0) {
+        startype_error(errornum, star->spec_class,
+                                 star->spec_num,
+                                 star->lum_id);
+        free(star);
+        return(NULL);
+    }
+    /*
+     *  Translate the command-line 'lum_id' into a 'lum_type':
+     */
+    switch (star->lum_id) {
+        case 'S':
+            star->lum_type = SUPERGIANT;
+            break;
+        case 'G':
+            star->lum_type = GIANT;
+            break;
+        case 'D':
+            star->lum_type = WHITE_DWARF;
+            break;
+        case 'M':
+        default:
+            star->lum_type = MAIN_SEQUENCE;
+            break;
+    }
+    return(star);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -154,7 +512,7 @@ void usage (char *progname)
 {
 
     fprintf(stderr,
-        "%s: Usage: [-g] [-m] [-s#] [-v#] [-tl#l/#]\n", progname);
+        "%s: Usage: [-g] [-m] [-s#] [-v#] [-tl#l/#] [-n#] [-j#] [-w#] [-u] [-z] [-L<socket>] [-C#] [-D<dir>] [-P#] [-B#] [-bi#] [-bs#] [-bt#] [-f<file>] [-p<name>=#] [-S<sweep>] [-A] [-E<file>] [-M#,#] [-K#] [-F<fields>] [-Q<conditions>] [-a[<file>]] [-I<file>] [-k#] [-r#[,star][,planets]] [-c<targets>] [-W<weights>] [-Hi/N] [-J<file>] [-l<file>] [-R] [-q<file>] [-x#] [-i[<file>]]\n", progname);
     fprintf(stderr,
         "\t -g        Display graphically (unimplemented)\n");
     fprintf(stderr,
@@ -165,9 +523,121 @@ void usage (char *progname)
         "\t -v#       Set the verbosity level to # (default is 0)\n");
     fprintf(stderr,
         "\t -tl#l/#   Choose the spectral type, luminosity class, and orbit\n");
+    fprintf(stderr,
+        "\t -n#       Generate # systems, using consecutive seeds\n");
+    fprintf(stderr,
+        "\t -j#       Use # processes to generate the systems\n");
+    fprintf(stderr,
+        "\t -w#       Hold up to # finished systems to keep output in order\n");
+    fprintf(stderr,
+        "\t -u        Write systems as they finish, in no particular order\n");
+    fprintf(stderr,
+        "\t -z        Compress the output (gzip format)\n");
+    fprintf(stderr,
+        "\t -L<sock>  Serve JSON requests on a Unix socket (-L- for stdin)\n");
+    fprintf(stderr,
+        "\t -C#       Keep up to # K of served systems in memory\n");
+    fprintf(stderr,
+        "\t -D<dir>   Also keep served systems on disk in <dir>\n");
+    fprintf(stderr,
+        "\t -P#       Keep # random systems ready to serve\n");
+    fprintf(stderr,
+        "\t -B#       Spend at most #%% of the CPU refilling them (50)\n");
+    fprintf(stderr,
+        "\t -bi#      Inject at most # protoplanets into each system\n");
+    fprintf(stderr,
+        "\t -bs#      Make at most # sweeps for dust in each system\n");
+    fprintf(stderr,
+        "\t -bt#      Spend at most # milliseconds on each system\n");
+    fprintf(stderr,
+        "\t -f<file>  Make the systems listed in <file> (-f- for stdin)\n");
+    fprintf(stderr,
+        "\t -p<name>=# Set a physical parameter, such as -palpha=4.5\n");
+    fprintf(stderr,
+        "\t -S<sweep> Make each system at every point of a sweep, such as\n"
+        "\t           -Sgrid,alpha=4:6:5,k=40:60:3 or -Slhs20,alpha=4:6\n");
+    fprintf(stderr,
+        "\t -A        Write a snapshot of each system once accretion is over\n");
+    fprintf(stderr,
+        "\t -E<file>  Finish the systems in a catalog of snapshots (-E- for stdin)\n");
+    fprintf(stderr,
+        "\t -M#,#     Build moons only when wanted: for the planets listed,\n"
+        "\t           or for all of them with -m\n");
+    fprintf(stderr,
+        "\t -K#       Use # processes to build the moons of each system\n");
+    fprintf(stderr,
+        "\t -F<list>  Work out only these characteristics of each planet,\n"
+        "\t           such as -Fsurf_temp,hydrosphere\n");
+    fprintf(stderr,
+        "\t -Q<list>  Write only the systems meeting these conditions, such as\n"
+        "\t           -Qspectral=GK,luminosity=V,surf_temp=270:310\n");
+    fprintf(stderr,
+        "\t -a<file>  Write statistics of the systems rather than the systems,\n"
+        "\t           saving them in <file> if one is given\n");
+    fprintf(stderr,
+        "\t -I<file>  Add the statistics saved in <file> to those of this run\n");
+    fprintf(stderr,
+        "\t -k#       List the # most Earth-like planets rather than the systems\n");
+    fprintf(stderr,
+        "\t -r#[,star][,planets] Write only a random sample of # systems (of\n"
+        "\t           each kind of primary, or number of planets)\n");
+    fprintf(stderr,
+        "\t -c<targets> Stop once these statistics are known, such as\n"
+        "\t           -cplanets=0.5,gas_giants@G V=0.02 (up to -n systems)\n");
+    fprintf(stderr,
+        "\t -W<weights> Make some kinds of primary more often, weighting each\n"
+        "\t           system to make up for it, such as -WB V=100,Ia=10%%\n");
+    fprintf(stderr,
+        "\t -Hi/N     Make only shard i (from 0) of N of the batch, for -J\n");
+    fprintf(stderr,
+        "\t -J<file>  Merge the shards of a batch into the whole of it\n");
+    fprintf(stderr,
+        "\t -l<file>  Keep a journal in <file> of how far the batch has got\n");
+    fprintf(stderr,
+        "\t -R        Carry on the batch in the journal, appending (>>) to its output\n");
+    fprintf(stderr,
+        "\t -q<file>  Carry on past systems that crash, listing them in <file>\n");
+    fprintf(stderr,
+        "\t -x#       ... and past systems that take more than # seconds\n");
+    fprintf(stderr,
+        "\t -i<file>  Report the time each stage of the systems took, also\n"
+        "\t           as JSON in <file> if one is given\n");
     exit (1);
 }
 
+/*--------------------------------------------------------------------------*/
+/*   Read a list of stars given just as with '-t', separated by spaces or   */
+/*   commas, into '*list'.  FALSE is returned if any of them is bad.  Note  */
+/*   that 'specs' is broken up in the process.                              */
+/*--------------------------------------------------------------------------*/
+int read_star_list(char *specs, star_pointer *list)
+{
+    star_pointer *tail;
+    char *spec;
+
+    *list = NULL;
+    tail = list;
+    for (spec = strtok(specs, " ,\t\n"); spec != NULL; spec = strtok(NULL, " ,\t\n")) {
+        if ((*tail = read_startype(spec)) == NULL) {
+            free_star_list(*list);
+            *list = NULL;
+            return(FALSE);
+        }
+        tail = &((*tail)->next_star);
+    }
+    return(TRUE);
+}
+
+void free_star_list(star_pointer star)
+{
+    star_pointer next_star;
+
+    for (; star != NULL; star = next_star) {
+        next_star = star->next_star;
+        free(star);
+    }
+}
+
 /*--------------------------------------------------------------------------*/
 /*   Initialize the random-number generator.                                */
 /*--------------------------------------------------------------------------*/
@@ -182,23 +652,45 @@ void init()
         ftime(&grap);
         seed = (unsigned)((grap.time%100000)+grap.millitm);
     }
-    (void)srand(seed);
     printf("Starform - V%s\n", VERSION);
-    printf("Random number seed - %u\n", seed);
+    start_system(seed);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Seed the random-number generator for one system and note the seed at  */
+/*   the head of that system's description.                                 */
+/*--------------------------------------------------------------------------*/
+void start_system(unsigned seed)
+{
+    seed_random(seed);
+    fprintf(display_file, "Random number seed - %u\n", seed);
 }
 
 /*--------------------------------------------------------------------------*/
 /*   First, find out what kind of stars are in this system, then use the    */
 /*   'dist_masses' function to accrete dust and gasses into planets.        */
 /*   Finally, loop through each planet finding the physical                 */
-/*   characteristics of each one.                                           */
+/*   characteristics of each one.  The work is done a stage at a time by    */
+/*   'generate_step' (see step.c), here with no limit on each call.         */
 /*--------------------------------------------------------------------------*/
 void generate_stellar_system()
 {
-    planet_pointer planet;
-    planet_pointer moon;
+    gen_context context;
+
+    start_generation(&context);
+    while (generate_step(&context, 0L, 0L) != GEN_DONE)
+        ;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Build up the list of stars in this system, and work out all of their   */
+/*   characteristics.                                                       */
+/*--------------------------------------------------------------------------*/
+void make_stars()
+{
     star_pointer star;
     star_pointer previous_star;
+    star_pointer spec;
     char *buf;
     int temp;    /* Used in calculating the number of stars in a system */
     int star_number;/* The number of stars in this system.                 */
@@ -209,7 +701,28 @@ void generate_stellar_system()
      *  determine how many stars to generate, then create star types
      *  and orbital distances for each of those.
      */
+    system_weight = 1.0;
+    system_weighted = FALSE;
     if (flag_startype) {
+        /*
+         *  Work on a copy of the command-line stars, since accretion may
+         *  change a star's orbit and mass (see 'collide_planets'):
+         */
+        for (spec = star_specs; spec != NULL; spec = spec->next_star) {
+            if ((star = (stars *)malloc((unsigned)sizeof(stars))) == NULL) {
+                perror("malloc'ing memory for a star");
+                exit(1);
+            }
+            *star = *spec;
+            star->next_star = NULL;
+            if (spec == star_specs) {
+                sys.primary_star = star;
+            }
+            else {
+                previous_star->next_star = star;
+            }
+            previous_star = star;
+        }
         for (star = sys.primary_star; star != NULL; star = star->next_star) {
             star->stell_mass_ratio = star_mass(star->lum_type,
                                                star->spec_class,
@@ -279,10 +792,15 @@ void generate_stellar_system()
                 star->orbit_radius = random_number(1.0, 150.0);
             }
             previous_star = star;
-            star->lum_type = rand_type();
-            star->stell_mass_ratio = rand_star_mass(star->lum_type);
+            if ((temp == 1) && (star_weight_count > 0))
+                weighted_star(star);
+            else {
+                star->lum_type = rand_type();
+                star->stell_mass_ratio = rand_star_mass(star->lum_type);
+            }
             buf = classify(star->stell_mass_ratio, star->lum_type);
             (void)strncpy(star->star_type, buf, CLASSIFICATION_SIZE);
+            free(buf);
             star->next_star = NULL;
         }
     }
@@ -311,130 +829,123 @@ void generate_stellar_system()
         star->r_ecosphere = sqrt(star->stell_luminosity_ratio);
         star->r_greenhouse = star->r_ecosphere * GREENHOUSE_EFFECT_CONST;
     }
-    if (flag_verbose >= LEVEL1) {
-        printf("  Begin building main planetary orbits:\n");
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Work out the orbital zone, density and radius of a planet.  None of    */
+/*   these take any random numbers.                                         */
+/*--------------------------------------------------------------------------*/
+void size_planet(planet_pointer planet)
+{
+    planet->orbit_zone =orb_zone(planet->a,
+                     sys.primary_star->stell_luminosity_ratio);
+    if (planet->mass_type == GAS_GIANT) {
+        planet->density = empirical_density(planet->mass,
+                            planet->a,
+                            planet->mass_type,
+                            sys.primary_star->stell_luminosity_ratio);
+        planet->radius = volume_radius(planet->mass,
+                           planet->density);
     }
+    else {
+        planet->radius = kothari_radius(planet->mass,
+                        planet->mass_type,
+                        planet->orbit_zone);
+        planet->density = volume_density(planet->mass,
+                         planet->radius);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Find the physical characteristics of a planet that has survived       */
+/*   accretion, building its moons first if they were asked for.  This is  */
+/*   planet 'number' of the system (counting from 0, and leaving out the   */
+/*   stars), which picks its streams of random numbers.  A planet that has  */
+/*   been finished already (by a search) only has its moons built.          */
+/*--------------------------------------------------------------------------*/
+void finish_planet(planet_pointer planet, long number)
+{
+    double started;
+
+    if (planet->finished) {
+        if (flag_moons && !flag_lazy_moons && !planet->moons_built
+            && (planet->mass_type != STAR))
+            build_moons(planet);
+        return;
+    }
+    started = stage_clock();
+    use_stream(STREAM_ENVIRONMENT, number);
+    size_planet(planet);
 /*
- *  Now that we have the star information, build a planetary system
- *  through accretion.  Start by adding all the stars into the planet
- *  list, then use 'dist_masses' to inject protoplanets until there's
- *  no more gas or dust to collect:
- */
-    sys.inner_planet = init_planet_list(sys.primary_star);
-    sys.inner_planet = dist_masses(sys.primary_star->stell_mass_ratio,
-                       sys.primary_star->stell_luminosity_ratio,
-                       PLANET, sys.inner_planet, 0.0);
-/*
- *  Now check if each planet is within the radius of the primary star or
- *  at least close enough to be vaporized:
+ *  Build the planet's moons now if moons were specified on the command
+ *  line (and aren't to wait until they're asked for, or haven't already
+ *  been built by 'share_out_moons') and the 'planet' isn't really a
+ *  companion star.  The moons have a stream of random numbers of their
+ *  own, so that they don't change the planet's others:
  */
-    sys.inner_planet = check_planets(sys.inner_planet,
-            sys.primary_star->stell_luminosity_ratio,
-            sys.primary_star->stell_radius);
-    if (flag_verbose >= LEVEL1) {
-        printf("  Finished building planetary orbits\n");
+    planet->moon_seed = stream_start(STREAM_MOONS, number);
+    if (flag_moons && !flag_lazy_moons && !planet->moons_built
+        && (planet->mass_type != STAR)) {
+        stage_done(TIMING_ENVIRONMENT, started);
+        build_moons(planet);
+        started = stage_clock();
     }
-    for (planet=sys.inner_planet;
-         planet != NULL;
-         planet = planet->next_planet) {
-        /*
-         *  If this 'planet' is really a star, skip it:
-         */
-        if (planet->mass_type == STAR) {
-            continue;
-        }
-        planet->orbit_zone =orb_zone(planet->a,
-                         sys.primary_star->stell_luminosity_ratio);
-        if (planet->mass_type == GAS_GIANT) {
-            planet->density = empirical_density(planet->mass,
-                                planet->a,
-                                planet->mass_type,
-                                sys.primary_star->stell_luminosity_ratio);
-            planet->radius = volume_radius(planet->mass,
-                               planet->density);
-        }
-        else {
-            planet->radius = kothari_radius(planet->mass,
-                            planet->mass_type,
-                            planet->orbit_zone);
-            planet->density = volume_density(planet->mass,
-                             planet->radius);
-        }
 /*
- *  Build the planet's moons if moons were specified on the command line
- *  and the 'planet' isn't really a companion star:
+ *  Only the fields asked for with -F (and those they depend on) are
+ *  worked out:
  */
-        if (flag_moons && (planet->mass_type != STAR)) {
-            planet->first_moon =
-                dist_masses(planet->mass,
-                        sys.primary_star->stell_luminosity_ratio,
-                        MOON,
-                        NULL,
-                        planet->radius);
-            if (flag_verbose >= LEVEL1) {
-                printf("  Built moon orbits for a planet\n");
-            }
-            for (moon=planet->first_moon;
-                moon != NULL;
-                moon = moon->next_planet) {
-                if (moon->mass_type == GAS_GIANT) {
-                    moon->density = empirical_density(moon->mass,
-                                        planet->a,
-                                        moon->mass_type,
-                                        sys.primary_star->r_ecosphere);
-                    moon->radius = volume_radius(moon->mass,
-                                      moon->density);
-                }
-                else {
-                    moon->radius = kothari_radius(moon->mass,
-                                    moon->mass_type,
-                                    planet->orbit_zone);
-                    moon->density = volume_density(moon->mass,
-                                     moon->radius);
-                }
-                moon->surf_accel = accel(moon->mass, moon->radius);
-                moon->surf_grav = gravity(moon->surf_accel);
-            }
-        }
-        else {
-            planet->first_moon = NULL;
-        }
+    if (field_needed(FIELD_ORB_PERIOD))
         planet->orb_period = period(planet->a,
-                        planet->mass,
-                        sys.primary_star->stell_mass_ratio);
+                    planet->mass,
+                    sys.primary_star->stell_mass_ratio);
+    if (field_needed(FIELD_DAY)) {
         planet->day = day_length(planet->mass,
-                     planet->radius,
-                     planet->e,
-                     planet->density,
-                     planet->a,
-                     planet->orb_period,
-                     planet->mass_type,
-                     sys.primary_star->stell_mass_ratio,
-                     sys.primary_star->age);
+                 planet->radius,
+                 planet->e,
+                 planet->density,
+                 planet->a,
+                 planet->orb_period,
+                 planet->mass_type,
+                 sys.primary_star->stell_mass_ratio,
+                 sys.primary_star->age);
         planet->resonant_period = resonance;
+    }
+    /*
+     *  The axial tilt takes a random number; one is taken even if the
+     *  tilt isn't wanted, so that the others come out the same:
+     */
+    if (field_needed(FIELD_AXIAL_TILT))
         planet->axial_tilt = inclination(planet->a);
+    else (void)random_number(0.0, 1.0);
+    if (field_needed(FIELD_ESC_VELOCITY))
         planet->esc_velocity = escape_vel(planet->mass,
-                          planet->radius);
+                      planet->radius);
+    if (field_needed(FIELD_SURF_ACCEL))
         planet->surf_accel = accel(planet->mass,planet->radius);
+    if (field_needed(FIELD_RMS_VELOCITY))
         planet->rms_velocity = rms_vel(MOL_NITROGEN,planet->a,
-             sys.primary_star->stell_luminosity_ratio);
+         sys.primary_star->stell_luminosity_ratio);
+    if (field_needed(FIELD_MOLEC_WEIGHT))
         planet->molec_weight = molecule_limit(planet->mass,
-                              planet->radius);
-        if (planet->mass_type == GAS_GIANT) {
-            planet->surf_grav = 0.0;
-            planet->greenhouse_effect = FALSE;
-            planet->volatile_gas_inventory = 0.0;
-            planet->surf_pressure = 0.0;
-            planet->boil_point = 0.0;
-            planet->hydrosphere = 0.0;
-            planet->albedo = about(GAS_GIANT_ALBEDO,0.1);
-            planet->surf_temp = 0.0;
-        }
-        else {
+                          planet->radius);
+    if (planet->mass_type == GAS_GIANT) {
+        planet->surf_grav = 0.0;
+        planet->greenhouse_effect = FALSE;
+        planet->volatile_gas_inventory = 0.0;
+        planet->surf_pressure = 0.0;
+        planet->boil_point = 0.0;
+        planet->hydrosphere = 0.0;
+        planet->albedo = about(GAS_GIANT_ALBEDO,0.1);
+        planet->surf_temp = 0.0;
+    }
+    else {
+        if (field_needed(FIELD_SURF_GRAV))
             planet->surf_grav = gravity(planet->surf_accel);
+        if (field_needed(FIELD_GREENHOUSE))
             planet->greenhouse_effect=grnhouse(planet->orbit_zone,
-                               planet->a,
-                               sys.primary_star->r_greenhouse);
+                           planet->a,
+                           sys.primary_star->r_greenhouse);
+        if (field_needed(FIELD_VOLATILES))
             planet->volatile_gas_inventory =
                 vol_inventory(planet->mass,
                           planet->esc_velocity,
@@ -442,15 +953,154 @@ void generate_stellar_system()
                           sys.primary_star->stell_mass_ratio,
                           planet->orbit_zone,
                           planet->greenhouse_effect);
+        if (field_needed(FIELD_SURF_PRESSURE))
             planet->surf_pressure = pressure(planet->volatile_gas_inventory,
-                     planet->radius,
-                     planet->surf_grav);
+                 planet->radius,
+                 planet->surf_grav);
+        if (field_needed(FIELD_BOIL_POINT)) {
             if (planet->surf_pressure == 0.0)
                 planet->boil_point = 0.0;
             else planet->boil_point = boiling_point(planet->surf_pressure);
+        }
+        if (field_needed(FIELD_SURF_TEMP))
             iterate_surface_temp(&(planet), sys.primary_star->r_ecosphere);
+    }
+    if (flag_top > 0)
+        planet->esi = similarity(planet);
+    planet->finished = TRUE;
+    stage_done(TIMING_ENVIRONMENT, started);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Accrete the moons of a planet from its moon seed, leaving the current  */
+/*   stream of random numbers just as it was.                               */
+/*--------------------------------------------------------------------------*/
+void build_moons(planet_pointer planet)
+{
+    planet_pointer moon;
+    unsigned long saved_state;
+    double started;
+
+    started = stage_clock();
+    saved_state = random_state;
+    random_state = planet->moon_seed;
+    planet->first_moon =
+        dist_masses(planet->mass,
+                sys.primary_star->stell_luminosity_ratio,
+                MOON,
+                NULL,
+                planet->radius);
+    random_state = saved_state;
+    planet->moons_built = TRUE;
+    if (flag_verbose >= LEVEL1) {
+        printf("  Built moon orbits for a planet\n");
+    }
+    for (moon=planet->first_moon;
+        moon != NULL;
+        moon = moon->next_planet) {
+        if (moon->mass_type == GAS_GIANT) {
+            moon->density = empirical_density(moon->mass,
+                                planet->a,
+                                moon->mass_type,
+                                sys.primary_star->r_ecosphere);
+            moon->radius = volume_radius(moon->mass,
+                              moon->density);
+        }
+        else {
+            moon->radius = kothari_radius(moon->mass,
+                            moon->mass_type,
+                            planet->orbit_zone);
+            moon->density = volume_density(moon->mass,
+                             moon->radius);
         }
+        moon->surf_accel = accel(moon->mass, moon->radius);
+        moon->surf_grav = gravity(moon->surf_accel);
+    }
+    stage_done(TIMING_MOONS, started);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Return the first moon of a finished planet, accreting its moons the    */
+/*   first time they are asked for.  They come out just as they would have  */
+/*   with '-m'.  Moons built this late aren't counted against the system's  */
+/*   work budgets, though each set of moons is still held to them.          */
+/*--------------------------------------------------------------------------*/
+planet_pointer planet_moons(planet_pointer planet)
+{
+    work_budget system_budget;
+
+    if (!planet->moons_built && (planet->mass_type != STAR)) {
+        system_budget = budget;
+        budget.injections = 0;
+        budget.sweeps = 0;
+        budget.tripped = 0;
+        budget.started = wall_clock();
+        build_moons(planet);
+        budget = system_budget;
+    }
+    return(planet->first_moon);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the planets whose moons are wanted, given with '-M' as a list of  */
+/*   planet numbers such as "3,5".  FALSE is returned if it makes no sense. */
+/*   Note that 'list' is broken up in the process.                          */
+/*--------------------------------------------------------------------------*/
+int read_moon_list(char *list)
+{
+    char *word, *end;
+
+    moon_list_count = 0;
+    for (word = strtok(list, " ,"); word != NULL; word = strtok(NULL, " ,")) {
+        if (moon_list_count == MAX_MOON_LIST)
+            return(FALSE);
+        moon_list[moon_list_count] = strtol(word, &end, 10);
+        if ((*end != '\0') || (moon_list[moon_list_count] < 1))
+            return(FALSE);
+        moon_list_count++;
     }
+    return(TRUE);
 }
 
+/*--------------------------------------------------------------------------*/
+/*   TRUE if the moons of planet 'number' (counting from 1, as they are     */
+/*   displayed) are wanted.                                                 */
+/*--------------------------------------------------------------------------*/
+int moons_wanted(long number)
+{
+    int i;
 
+    if (flag_moons)
+        return(TRUE);
+    for (i = 0; i < moon_list_count; i++) {
+        if (moon_list[i] == number)
+            return(TRUE);
+    }
+    return(FALSE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Release all the stars, planets and moons of a system so that another   */
+/*   one can be generated in its place.                                     */
+/*--------------------------------------------------------------------------*/
+void free_system(sys_pointer system)
+{
+    planet_pointer planet, next_planet;
+    planet_pointer moon, next_moon;
+    star_pointer star, next_star;
+
+    for (planet = system->inner_planet; planet != NULL; planet = next_planet) {
+        next_planet = planet->next_planet;
+        for (moon = planet->first_moon; moon != NULL; moon = next_moon) {
+            next_moon = moon->next_planet;
+            free(moon);
+        }
+        free(planet);
+    }
+    for (star = system->primary_star; star != NULL; star = next_star) {
+        next_star = star->next_star;
+        free(star);
+    }
+    system->inner_planet = NULL;
+    system->primary_star = NULL;
+}
@@ -118,6 +118,30 @@ spectral_info sg_stardata[] = {
 	{'O', 0, 90.0,  6 }
 };
 
+/*
+ *  The arrays above, by luminosity class:
+ */
+luminosity_info lum_classes[LUMINOSITY_CLASSES] = {
+	{"V",   MAIN_SEQUENCE, ms_stardata},
+	{"D",   WHITE_DWARF,   wd_stardata},
+	{"III", GIANT,         g_stardata},
+	{"Ia",  SUPERGIANT,    sg_stardata}
+};
+
+/*
+ *  Importance sampling of primaries (the -W flag): the weights or shares
+ *  given for each class, and the chance of a primary falling in each
+ *  piece of a line of the arrays above (cut where 'classify' would name
+ *  it differently), naturally and as weighted.  The weight of the
+ *  system being made is what it counts for in the population.
+ */
+star_weight star_weights[MAX_STAR_WEIGHTS];
+int star_weight_count = 0;
+star_cell star_cells[STAR_CELLS];
+int star_cell_count = 0;
+double system_weight = 1.0;
+int system_weighted = FALSE;
+
 /*--------------------------------------------------------------------------*/
 /*   This is eq. 3.52 from "Astrophysics I" by Bowers and Deeming.          */
 /*   The mass_ratio is unitless and is a ratio of the stellar mass to that  */
@@ -362,11 +386,11 @@ int verify_startype (char lum_id, int spec_num, char spec_class)
 void startype_error(int errornum, char spec_class, int spec_num, char lum_id)
 {
 	if (errornum & BAD_SPECTRA)
-		printf("ERROR: invalid spectral class <%c>\n", spec_class);
+		fprintf(stderr, "ERROR: invalid spectral class <%c>\n", spec_class);
 	if (errornum & BAD_MOD)
-		printf("ERROR: invalid spectral class modifier <%d>\n", spec_num);
+		fprintf(stderr, "ERROR: invalid spectral class modifier <%d>\n", spec_num);
 	if (errornum & BAD_LUMINOSITY)
-		printf("ERROR: invalid luminosity class <%c>\n", lum_id);
+		fprintf(stderr, "ERROR: invalid luminosity class <%c>\n", lum_id);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -398,7 +422,7 @@ double rand_star_mass (int startype)
 	temp = (int)random_number(0.0, 100.0);
 	for (i=0; (i <= 14); i++) {
 		percent = percent + stardata[i].percentage;
-		if (temp <= percent) {
+		if ((temp <= percent) && (stardata[i].max_mass > 0.0)) {
 			mass = random_number(stardata[i].max_mass, prev_mass);
 			return(mass);
 		}
@@ -435,3 +459,241 @@ int rand_type (void) {
 		return(MAIN_SEQUENCE);
 	}
 }
+
+/*--------------------------------------------------------------------------*/
+/*   The chance of 'rand_type' choosing each luminosity class, and of       */
+/*   'rand_star_mass' choosing each line of its array (both draw a whole    */
+/*   number from 0 to 99, and a line of no mass is passed over).            */
+/*--------------------------------------------------------------------------*/
+double type_chance(int lum_type)
+{
+	switch (lum_type) {
+		case GIANT:
+			return(0.02 * 0.71);
+		case SUPERGIANT:
+			return(0.02 * 0.29);
+		case WHITE_DWARF:
+			return(0.09);
+		case MAIN_SEQUENCE:
+		default:
+			return(0.89);
+	}
+}
+
+double line_chance(spectral_info *stardata, int line)
+{
+	int i, below, upto;
+
+	if (stardata[line].max_mass <= 0.0)
+		return(0.0);
+	below = -1;
+	upto = 0;
+	for (i = 0; i <= line; i++) {
+		if ((i > 0) && (stardata[i - 1].max_mass > 0.0))
+			below = upto;
+		upto += stardata[i].percentage;
+	}
+	if (upto > 99)
+		upto = 99;
+	return((upto > below) ? (upto - below) / 100.0 : 0.0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The line of 'stardata' whose spectral class 'classify' gives a star    */
+/*   of 'mass_ratio', or -1 if the star is heavier than any of them.        */
+/*--------------------------------------------------------------------------*/
+int class_line(spectral_info *stardata, double mass_ratio)
+{
+	int i;
+
+	for (i = 0; (i < 14) && (stardata[i].max_mass < mass_ratio); i++)
+		;
+	return((stardata[i].max_mass < mass_ratio) ? -1 : i);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Decode the weights given with '-W', such as "B V=100,O=20%,Ia=50".     */
+/*   Each names a class of primary: a spectral class, a luminosity class    */
+/*   (V, III, Ia or D), or both; and either a weight, by which its chance   */
+/*   of being made is multiplied, or (with a '%') the share of the systems  */
+/*   that are to have one.  The first that matches a primary counts.  Each  */
+/*   line of the arrays above is then cut into pieces, each of whose masses */
+/*   'classify' gives the same spectral class, and their chances worked     */
+/*   out.  FALSE is returned if the weights can't be understood.            */
+/*--------------------------------------------------------------------------*/
+int read_star_weights(char *spec)
+{
+	star_weight *weight;
+	star_cell *cell;
+	spectral_info *stardata;
+	double natural[MAX_STAR_WEIGHTS];
+	double shared, rest, total, line_natural, low, high, top;
+	char *c, *end;
+	int i, j, k, line, length;
+
+	for (c = spec; *c != '\0'; c = end) {
+		if (star_weight_count == MAX_STAR_WEIGHTS) {
+			fprintf(stderr, "ERROR: too many weights given with -W\n");
+			return(FALSE);
+		}
+		weight = &star_weights[star_weight_count++];
+		weight->spec_class = '\0';
+		weight->lum_type = 0;
+		while ((*c != '=') && (*c != '\0')) {
+			length = (int)strcspn(c, " =");
+			if ((length == 1) && (strchr("OBAFGKM", *c) != NULL))
+				weight->spec_class = *c;
+			else {
+				for (i = 0; i < LUMINOSITY_CLASSES; i++) {
+					if ((length == (int)strlen(lum_classes[i].name))
+						&& (strncmp(c, lum_classes[i].name, (size_t)length) == 0))
+						weight->lum_type = lum_classes[i].lum_type;
+				}
+				if (weight->lum_type == 0) {
+					fprintf(stderr, "ERROR: bad class of star in <%s>\n", spec);
+					return(FALSE);
+				}
+			}
+			c += length;
+			if (*c == ' ')
+				c++;
+		}
+		if (*c != '=') {
+			fprintf(stderr, "ERROR: no weight given in <%s>\n", spec);
+			return(FALSE);
+		}
+		weight->value = strtod(++c, &end);
+		weight->quota = (*end == '%');
+		if (weight->quota)
+			end++;
+		if ((end == c) || (weight->value < 0.0) || ((*end != ',') && (*end != '\0'))) {
+			fprintf(stderr, "ERROR: bad weight in <%s>\n", spec);
+			return(FALSE);
+		}
+		if (*end == ',')
+			end++;
+	}
+	/*
+	 *  A line's mass is drawn evenly between its 'max_mass' and the one
+	 *  before, but the arrays aren't all in order of mass, so 'classify'
+	 *  may not name the star after the line it came from.  Cut each line
+	 *  at the masses where the name changes, and find the natural chance
+	 *  of each piece and which weight it takes:
+	 */
+	for (i = 0; i < star_weight_count; i++)
+		natural[i] = 0.0;
+	for (i = 0; i < LUMINOSITY_CLASSES; i++) {
+		stardata = lum_classes[i].stardata;
+		for (j = 0; j < SPECTRAL_LINES; j++) {
+			line_natural = type_chance(lum_classes[i].lum_type)
+						   * line_chance(stardata, j);
+			low = (j == 0) ? 0.0 : stardata[j - 1].max_mass;
+			high = stardata[j].max_mass;
+			if (low > high) {
+				top = low;
+				low = high;
+				high = top;
+			}
+			do {
+				top = high;
+				for (k = 0; k < SPECTRAL_LINES; k++) {
+					if ((stardata[k].max_mass > low) && (stardata[k].max_mass < top))
+						top = stardata[k].max_mass;
+				}
+				cell = &star_cells[star_cell_count++];
+				cell->lum_type = lum_classes[i].lum_type;
+				line = class_line(stardata, (low + top) / 2.0);
+				cell->spec_class = (line < 0) ? '?' : stardata[line].spec_class;
+				cell->low_mass = low;
+				cell->high_mass = top;
+				cell->natural = (high > low) ? line_natural * (top - low) / (high - low)
+								: line_natural;
+				cell->weight = -1;
+				for (weight = star_weights; weight < &star_weights[star_weight_count]; weight++) {
+					if (((weight->spec_class == '\0')
+						 || (weight->spec_class == cell->spec_class))
+						&& ((weight->lum_type == 0) || (weight->lum_type == cell->lum_type))) {
+						cell->weight = (int)(weight - star_weights);
+						break;
+					}
+				}
+				if (cell->weight >= 0)
+					natural[cell->weight] += cell->natural;
+				low = top;
+			} while (low < high);
+		}
+	}
+	/*
+	 *  Share out the systems: first to the classes given a share, then
+	 *  the rest in proportion to the natural chances, as weighted:
+	 */
+	shared = 0.0;
+	for (i = 0; i < star_weight_count; i++) {
+		if (!star_weights[i].quota)
+			continue;
+		if (natural[i] == 0.0) {
+			fprintf(stderr, "ERROR: a class given a share with -W is never made\n");
+			return(FALSE);
+		}
+		shared += star_weights[i].value / 100.0;
+	}
+	if (shared > 1.0 + 1.0E-9) {
+		fprintf(stderr, "ERROR: the shares given with -W come to more than 100%%\n");
+		return(FALSE);
+	}
+	rest = 0.0;
+	total = 0.0;
+	for (cell = star_cells; cell < &star_cells[star_cell_count]; cell++) {
+		if (cell->weight < 0)
+			rest += cell->natural;
+		else if (!star_weights[cell->weight].quota)
+			rest += cell->natural * star_weights[cell->weight].value;
+	}
+	for (cell = star_cells; cell < &star_cells[star_cell_count]; cell++) {
+		if (cell->weight < 0)
+			cell->chance = (rest > 0.0) ? (1.0 - shared) * cell->natural / rest : 0.0;
+		else if (star_weights[cell->weight].quota)
+			cell->chance = star_weights[cell->weight].value / 100.0
+						   * cell->natural / natural[cell->weight];
+		else cell->chance = (rest > 0.0) ? (1.0 - shared) * cell->natural
+								* star_weights[cell->weight].value / rest : 0.0;
+		total += cell->chance;
+	}
+	if (total <= 0.0) {
+		fprintf(stderr, "ERROR: the weights given with -W leave no star to make\n");
+		return(FALSE);
+	}
+	return(TRUE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Choose the luminosity class and mass of a primary by the weighted      */
+/*   chances, in place of 'rand_type' and 'rand_star_mass', and note the    */
+/*   weight of the system: the natural chance of its primary over the       */
+/*   weighted one.                                                          */
+/*--------------------------------------------------------------------------*/
+void weighted_star(star_pointer star)
+{
+	star_cell *cell, *chosen;
+	double choice, so_far;
+
+	/*
+	 *  Should rounding leave the choice past the last line, the last
+	 *  line that can be chosen is:
+	 */
+	choice = random_number(0.0, 1.0);
+	so_far = 0.0;
+	chosen = NULL;
+	for (cell = star_cells; cell < &star_cells[star_cell_count]; cell++) {
+		if (cell->chance <= 0.0)
+			continue;
+		chosen = cell;
+		so_far += cell->chance;
+		if (choice < so_far)
+			break;
+	}
+	star->lum_type = chosen->lum_type;
+	star->stell_mass_ratio = random_number(chosen->high_mass, chosen->low_mass);
+	system_weight = chosen->natural / chosen->chance;
+	system_weighted = TRUE;
+}
@@ -0,0 +1,283 @@
+/*----------------------------------------------------------------------*/
+/*                                step.c                                */
+/*                                                                      */
+/*  Routines for generating a system a little at a time, for programs   */
+/*  that can't afford to wait while a whole system is built (a game     */
+/*  drawing a frame, say).  The caller sets up a context with           */
+/*  'start_generation', then calls 'generate_step' as often as it       */
+/*  likes, each time saying how many steps or how many microseconds it  */
+/*  can spare.  A step is the injection of a single protoplanet, or     */
+/*  the finishing of a single planet (moons and all).  The stars are    */
+/*  handed to the caller as soon as they are settled, and each planet   */
+/*  as soon as it is finished, so a partly built system can be shown.   */
+/*                                                                      */
+/*  However it is generated, each system is held to the work budgets    */
+/*  given with the -b flags.  A system that runs out of injections or   */
+/*  'collect_dust' sweeps stops accreting and is finished with what it  */
+/*  has.  One that runs out of time also loses any planets not yet      */
+/*  finished.  Either way the system is marked as truncated.            */
+/*                                                                      */
+/*  The system is built in 'sys', and the random numbers come from the  */
+/*  streams in utils.c, just as with 'generate_stellar_system'.  Only   */
+/*  one system can be under way at a time, and the caller must leave    */
+/*  'random_number' alone between steps if the system is to match the   */
+/*  one its seed gives.                                                 */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+
+#include	"config.h"
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern star_system sys;
+extern physics_params physics;
+extern int flag_verbose;
+extern int flag_moons;
+extern long flag_max_injections;
+extern long flag_max_sweeps;
+extern long flag_max_msec;
+
+/*
+ *  The work that has gone into the system being built:
+ */
+work_budget budget;
+
+/*--------------------------------------------------------------------------*/
+/*   Check the work done so far against the budgets, noting any that have   */
+/*   run out.  TRUE is returned if any has.                                 */
+/*--------------------------------------------------------------------------*/
+int over_budget(void)
+{
+    if ((flag_max_injections > 0) && (budget.injections >= flag_max_injections))
+        budget.tripped |= BUDGET_INJECTIONS;
+    if ((flag_max_sweeps > 0) && (budget.sweeps >= flag_max_sweeps))
+        budget.tripped |= BUDGET_SWEEPS;
+    if (flag_max_msec > 0) {
+        budget.msec = (long)((wall_clock() - budget.started) * 1000.0);
+        if (budget.msec >= flag_max_msec)
+            budget.tripped |= BUDGET_TIME;
+    }
+    return(budget.tripped != 0);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Name the budgets in 'tripped', as in "injections, time".               */
+/*--------------------------------------------------------------------------*/
+char *budget_names(int tripped)
+{
+    static char names[32];
+
+    names[0] = '\0';
+    if (tripped & BUDGET_INJECTIONS)
+        strcat(names, "injections, ");
+    if (tripped & BUDGET_SWEEPS)
+        strcat(names, "sweeps, ");
+    if (tripped & BUDGET_TIME)
+        strcat(names, "time, ");
+    if (names[0] != '\0')
+        names[strlen(names) - 2] = '\0';
+    return(names);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Take out of the system every planet from 'first' on that hasn't been   */
+/*   finished (the stars among them stay).                                  */
+/*--------------------------------------------------------------------------*/
+void drop_unfinished(planet_pointer first)
+{
+    planet_pointer planet, trailer, doomed_planet;
+    int dropping = FALSE;
+
+    trailer = NULL;
+    planet = sys.inner_planet;
+    while (planet != NULL) {
+        if (planet == first)
+            dropping = TRUE;
+        if (dropping && (planet->mass_type != STAR)) {
+            doomed_planet = planet;
+            planet = planet->next_planet;
+            if (trailer == NULL)
+                sys.inner_planet = planet;
+            else trailer->next_planet = planet;
+            free(doomed_planet);
+        }
+        else {
+            trailer = planet;
+            planet = planet->next_planet;
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Get a context ready to build a new system in 'sys'.  The random        */
+/*   number generator should already have been seeded (see start_system).   */
+/*--------------------------------------------------------------------------*/
+void start_generation(gen_context *context)
+{
+    context->stage = STAGE_STARS;
+    context->last_stage = STAGE_PLANETS;
+    context->next_planet = NULL;
+    context->planet_number = 0;
+    context->star_done = NULL;
+    context->planet_done = NULL;
+    context->physics = physics;
+    budget.injections = 0;
+    budget.sweeps = 0;
+    budget.msec = 0;
+    budget.tripped = 0;
+    budget.started = wall_clock();
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Get a context ready to finish the planets of a system whose accretion  */
+/*   is already over, such as one read back from a snapshot.  The budget    */
+/*   should already hold the work that went into the accretion.             */
+/*--------------------------------------------------------------------------*/
+void resume_generation(gen_context *context)
+{
+    context->last_stage = STAGE_PLANETS;
+    context->star_done = NULL;
+    context->planet_done = NULL;
+    context->physics = physics;
+    budget.started = wall_clock() - budget.msec / 1000.0;
+    start_planets(context);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Move on to finishing the planets, one to a step.  If their moons are   */
+/*   to be built by several processes (-K), they are all built first, in a  */
+/*   single step.                                                           */
+/*--------------------------------------------------------------------------*/
+void start_planets(gen_context *context)
+{
+    double started;
+
+    context->stage = STAGE_PLANETS;
+    context->next_planet = sys.inner_planet;
+    context->planet_number = 0;
+    started = stage_clock();
+    share_out_moons();
+    if (flag_moons)
+        stage_done(TIMING_MOONS, started);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   TRUE once 'steps' have used up the step or time limit (either of which */
+/*   may be 0 for no limit).                                                */
+/*--------------------------------------------------------------------------*/
+int out_of_time(long steps, long max_steps, long max_usec, double started)
+{
+    if (steps == 0)
+        return(FALSE);
+    if ((max_steps > 0) && (steps >= max_steps))
+        return(TRUE);
+    if ((max_usec > 0) && ((wall_clock() - started) * 1.0E6 >= max_usec))
+        return(TRUE);
+    return(FALSE);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Carry on building the system for up to 'max_steps' steps or            */
+/*   'max_usec' microseconds.  At least one step is always taken, so that   */
+/*   the system gets built however small the limits.  GEN_DONE is returned  */
+/*   once the system is finished (or 'last_stage' is over), and             */
+/*   GEN_IN_PROGRESS otherwise.  The context's parameters are put in use    */
+/*   for each call, so they hold however the system was put aside.          */
+/*--------------------------------------------------------------------------*/
+int generate_step(gen_context *context, long max_steps, long max_usec)
+{
+    star_pointer star;
+    planet_pointer planet;
+    double started, stage_started;
+    long steps = 0;
+
+    started = (max_usec > 0) ? wall_clock() : 0.0;
+    physics = context->physics;
+    while ((context->stage != STAGE_DONE) && (context->stage <= context->last_stage)) {
+        if (out_of_time(steps, max_steps, max_usec, started))
+            return(GEN_IN_PROGRESS);
+        switch (context->stage) {
+            case STAGE_STARS:
+                stage_started = stage_clock();
+                make_stars();
+                stage_done(TIMING_STARS, stage_started);
+                if (context->star_done != NULL) {
+                    for (star = sys.primary_star; star != NULL; star = star->next_star)
+                        (*context->star_done)(star);
+                }
+                if (flag_verbose >= LEVEL1) {
+                    printf("  Begin building main planetary orbits:\n");
+                }
+                /*
+                 *  Now that we have the star information, build a
+                 *  planetary system through accretion.  Start by adding
+                 *  all the stars into the planet list, then inject
+                 *  protoplanets until there's no more gas or dust to
+                 *  collect:
+                 */
+                stage_started = stage_clock();
+                use_stream(STREAM_ACCRETION, 0L);
+                sys.inner_planet = init_planet_list(sys.primary_star);
+                start_accretion(&context->cloud,
+                                sys.primary_star->stell_mass_ratio,
+                                sys.primary_star->stell_luminosity_ratio,
+                                PLANET, sys.inner_planet, 0.0);
+                stage_done(TIMING_PLANET_LIST, stage_started);
+                context->stage = STAGE_ACCRETION;
+                break;
+            case STAGE_ACCRETION:
+                steps++;
+                stage_started = stage_clock();
+                if (inject_protoplanet(&context->cloud)) {
+                    stage_done(TIMING_ACCRETION, stage_started);
+                    break;
+                }
+                sys.inner_planet = finish_accretion();
+                stage_done(TIMING_ACCRETION, stage_started);
+                /*
+                 *  Now check if each planet is within the radius of the
+                 *  primary star or at least close enough to be vaporized:
+                 */
+                stage_started = stage_clock();
+                sys.inner_planet = check_planets(sys.inner_planet,
+                        sys.primary_star->stell_luminosity_ratio,
+                        sys.primary_star->stell_radius);
+                stage_done(TIMING_CHECK, stage_started);
+                if (flag_verbose >= LEVEL1) {
+                    printf("  Finished building planetary orbits\n");
+                }
+                if (context->last_stage == STAGE_ACCRETION)
+                    context->stage = STAGE_DONE;
+                else start_planets(context);
+                break;
+            case STAGE_PLANETS:
+                if ((planet = context->next_planet) == NULL) {
+                    context->stage = STAGE_DONE;
+                    break;
+                }
+                context->next_planet = planet->next_planet;
+                /*
+                 *  If this 'planet' is really a star, skip it:
+                 */
+                if (planet->mass_type == STAR)
+                    break;
+                if (over_budget() && (budget.tripped & BUDGET_TIME)) {
+                    drop_unfinished(planet);
+                    context->stage = STAGE_DONE;
+                    break;
+                }
+                steps++;
+                finish_planet(planet, context->planet_number++);
+                if (context->planet_done != NULL)
+                    (*context->planet_done)(planet);
+                break;
+        }
+    }
+    budget.msec = (long)((wall_clock() - budget.started) * 1000.0);
+    return(GEN_DONE);
+}
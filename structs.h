@@ -62,6 +62,10 @@ typedef struct planets_struct {
 	planet_pointer first_moon;
 	planet_pointer next_planet;
 	star_pointer star_ptr;
+	unsigned long moon_seed;	/* where its moons' random numbers start */
+	int moons_built;	/* TRUE once 'first_moon' is filled in */
+	int finished;		/* TRUE once 'finish_planet' has sized it */
+	double esi;		/* Earth Similarity Index, with -k   */
 } planets;
 
 
@@ -73,6 +77,153 @@ typedef struct dust_struct {
 	dust_pointer next_band;
 } dust;
 
+/*
+ *  The limits of a cloud of dust and gas about a body, kept between
+ *  protoplanet injections (see 'start_accretion'):
+ */
+typedef struct Accretion {
+	double mass_ratio;          /* mass of the central body            */
+	double stell_luminosity_ratio;
+	int mass_type;              /* PLANET or MOON                      */
+	double planet_inner_bound;  /* closest and farthest a body can be  */
+	double planet_outer_bound;
+	long injections;            /* protoplanets injected so far        */
+} accretion;
+
+/*
+ *  The physical parameters of the accretion model (see params.c):
+ */
+typedef struct Physics_Params {
+	double dust_density_coeff;  /* A in Dole's paper                   */
+	double alpha;               /* used in density calcs               */
+	double n;                   /* used in density calcs               */
+	double k;                   /* gas/dust ratio                      */
+	double b;                   /* used in crit_mass calc              */
+	double eccentricity_coeff;
+	double cloud_eccentricity;
+	double protoplanet_mass;    /* in solar masses                     */
+	double gas_retention_threshold; /* ratio of esc vel to RMS vel    */
+} physics_params;
+
+typedef struct Parameter_Info {
+	char *name;
+	double *value;
+	int given;                  /* set with -p on the command line     */
+} parameter_info;
+
+typedef struct Field_Info {
+	char *name;
+	long bit;                   /* FIELD_RADIUS, ...                   */
+	long needs;                 /* the fields it is worked out from    */
+} field_info;
+
+typedef struct Search_Term {
+	char *name;
+	int kind;                   /* TERM_SPECTRAL, ...                  */
+	int stage;                  /* the stage after which it is decided */
+	long field;                 /* for TERM_FIELD, the field it tests  */
+} search_term;
+
+typedef struct Search_Condition {
+	search_term *term;
+	double low;                 /* the range of values allowed         */
+	double high;
+	char text[CLASSIFICATION_SIZE]; /* or the classes, for the stars    */
+} search_condition;
+
+/*
+ *  A census of a batch (see census.c).  Each statistic has its moments
+ *  and a histogram (with a bin at each end for the values outside its
+ *  range), for each kind of primary star.
+ */
+typedef struct Running_Stat {
+	long count;
+	double mean;
+	double m2;                  /* sum of squared differences from mean */
+	double weight;              /* sum of the weights of the values    */
+	double weight2;             /* ... and of their squares            */
+	double min;
+	double max;
+} running_stat;
+
+typedef struct Census_Stat {
+	running_stat moments;
+	double bins[CENSUS_BINS + 2];  /* weight of the values in each     */
+} census_stat;
+
+typedef struct Census_Group {
+	char name[CLASSIFICATION_SIZE]; /* "all", or a class such as "G V" */
+	long systems;
+	census_stat stats[CENSUS_STATS];
+} census_group;
+
+typedef struct Census_Info {
+	char *name;
+	double low;                 /* the range of the histogram          */
+	double high;
+	int log_scale;              /* TRUE if binned by log10 of values   */
+	int whole;                  /* TRUE for counts (whole numbers)     */
+} census_info;
+
+/*
+ *  A statistic a batch is run until it knows well enough (see converge.c):
+ */
+typedef struct Converge_Target {
+	int stat;                   /* CENSUS_PLANETS, ...                 */
+	char group[CLASSIFICATION_SIZE]; /* "all", or a class such as "G V" */
+	double width;               /* widest its interval may be          */
+	running_stat moments;       /* its values so far                   */
+} converge_target;
+
+/*
+ *  The ranking of the most Earth-like planets (see rank.c):
+ */
+typedef struct Similarity_Info {
+	long field;                 /* FIELD_RADIUS, ...                   */
+	double earth;               /* the Earth's value                   */
+	double weight;
+} similarity_info;
+
+typedef struct Ranked_Planet {
+	double esi;
+	long index;                 /* position of its system in the batch */
+	unsigned seed;
+	int planet;                 /* which planet of the system, from 1  */
+	double radius;              /* in the units of 'field_value'       */
+	double density;
+	double esc_velocity;
+	double surf_temp;
+	double surf_pressure;
+	double hydrosphere;
+	double weight;              /* of its system, with -W              */
+	char tag[TASK_LINE_SIZE];   /* parameters the system was made with */
+} ranked_planet;
+
+/*
+ *  Random samples of the systems of a batch (see sample.c):
+ */
+typedef struct Sampled_System {
+	unsigned long key;          /* the sample keeps the smallest keys  */
+	long index;                 /* position of the system in the batch */
+	char *text;                 /* the system's description            */
+	long length;
+	int stratum;                /* which sample, when written out      */
+} sampled_system;
+
+typedef struct Sample_Stratum {
+	char name[STRATUM_NAME_SIZE]; /* "all", or such as "G V, 5 planets" */
+	long systems;               /* systems of this kind made           */
+	long count;                 /* ... and kept                        */
+	sampled_system *kept;       /* a heap, with the largest key on top */
+} sample_stratum;
+
+typedef struct Sweep_Axis {
+	parameter_info *param;
+	double low;
+	double high;
+	long count;                 /* values taken, in a grid             */
+} sweep_axis;
+
 typedef struct Spectral_Info {
 	char spec_class;
 	int spec_num;
@@ -80,3 +231,125 @@ typedef struct Spectral_Info {
 	int percentage;
 } spectral_info;
 
+typedef struct Luminosity_Info {
+	char *name;                 /* "V", "D", "III" or "Ia"             */
+	int lum_type;               /* MAIN_SEQUENCE, ...                  */
+	spectral_info *stardata;
+} luminosity_info;
+
+/*
+ *  Importance sampling of primaries (the -W flag, see stars.c):
+ */
+typedef struct Star_Weight {
+	char spec_class;            /* 'B', ..., or 0 for any              */
+	int lum_type;               /* MAIN_SEQUENCE, ..., or 0 for any    */
+	double value;               /* a weight, or a percentage of systems */
+	int quota;                  /* TRUE if 'value' is a percentage     */
+} star_weight;
+
+typedef struct Star_Cell {
+	int lum_type;
+	char spec_class;            /* the class 'classify' gives it       */
+	double low_mass;            /* its range of masses                 */
+	double high_mass;
+	double natural;             /* chance of a primary falling in it   */
+	double chance;              /* ... as weighted                     */
+	int weight;                 /* which weight it takes, or -1        */
+} star_cell;
+
+/*
+ *  The times a stage of making systems took (see timing.c):
+ */
+typedef struct Timing_Histogram {
+	long count;
+	double total;               /* seconds                             */
+	double max;
+	long bins[TIMING_BINS];     /* sixteen to each doubling from 1 ns  */
+} timing_histogram;
+
+/*
+ *  Batch runs: each finished system is passed back from a worker process
+ *  as a header followed by 'length' bytes of text.
+ */
+typedef struct Record_Header {
+	long index;                 /* position of the system in the batch */
+	long length;                /* bytes of text following the header  */
+	int tripped;                /* budgets the system ran out of       */
+	int rejected;               /* REJECTED_STARS, ... in a search     */
+	running_stat targets[MAX_CONVERGE_TARGETS]; /* its values, with -c */
+} record_header;
+
+typedef struct Worker_Info {
+	long pid;
+	int task_fd;                /* systems to build are written here   */
+	int result_fd;              /* finished systems are read from here */
+	int in_flight;              /* systems handed out but not returned */
+	char *queued[WORKER_QUEUE_DEPTH]; /* their tasks, when supervised  */
+	int first_queued;           /* ... the oldest of them              */
+	long busy_since;            /* when it started on the oldest       */
+	int hung;                   /* killed for taking too long          */
+} worker_info;
+
+typedef struct Capture_Info {
+	FILE *saved;                /* 'display_file' before the capture   */
+	char *text;                 /* what was written, with open_memstream */
+	size_t size;
+} capture_info;
+
+/*
+ *  The server's cache of finished systems (see cache.c):
+ */
+typedef struct Cache_Entry *cache_pointer;
+
+typedef struct Cache_Entry {
+	char *key;                  /* seed, stars, moons and format       */
+	char *text;                 /* the system's description            */
+	long length;
+	unsigned long hash;
+	cache_pointer next_entry;   /* next in the same hash bucket        */
+	cache_pointer newer;        /* neighbours in order of last use     */
+	cache_pointer older;
+} cache_entry;
+
+/*
+ *  A ready-made random system in the server's pool (see pool.c):
+ */
+typedef struct Pool_Entry {
+	unsigned seed;              /* regenerates the system with '-s'    */
+	char *text;                 /* the system's description            */
+	long length;
+	int tripped;                /* budgets the system ran out of       */
+} pool_entry;
+
+/*
+ *  A system being generated a step at a time (see step.c).  The two
+ *  functions, if given, are called with each star as soon as the stars
+ *  are settled, and with each planet as soon as it is finished.
+ *  Generation can be stopped early, once the stars are settled or once
+ *  accretion is over, by setting 'last_stage' to STAGE_STARS or to
+ *  STAGE_ACCRETION, and after the stars it can be carried on by raising
+ *  'last_stage' again.  The system is built with the parameters in
+ *  'physics', which start out as those in use when it was begun.
+ */
+typedef struct Gen_Context {
+	int stage;                  /* STAGE_STARS, STAGE_ACCRETION, ...   */
+	int last_stage;             /* the last stage to be carried out    */
+	accretion cloud;            /* the cloud about the primary         */
+	planet_pointer next_planet; /* the next planet to be finished      */
+	long planet_number;         /* planets (not stars) finished so far */
+	physics_params physics;     /* the parameters it is built with     */
+	void (*star_done)(star_pointer);
+	void (*planet_done)(planet_pointer);
+} gen_context;
+
+/*
+ *  The work that has gone into the current system, and which of the
+ *  budgets set with the -b flags it has run out of (see step.c):
+ */
+typedef struct Work_Budget {
+	long injections;            /* protoplanets and protomoons         */
+	long sweeps;                /* passes of 'collect_dust'            */
+	long msec;                  /* wall-clock time taken               */
+	double started;
+	int tripped;                /* BUDGET_INJECTIONS, ... or'ed        */
+} work_budget;
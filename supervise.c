@@ -0,0 +1,252 @@
+/*----------------------------------------------------------------------*/
+/*                             supervise.c                              */
+/*                                                                      */
+/*  Keeping a batch going when one of its systems crashes or hangs the  */
+/*  worker process making it (the -q and -x flags).  Some seeds and     */
+/*  some settings of the parameters run into one of the checks that     */
+/*  give up on the whole run, or send a system round and round without  */
+/*  end.  Normally that stops the batch; with '-q<file>' the parent     */
+/*  keeps a copy of the tasks it has handed each worker instead, and    */
+/*  when a worker dies it notes the system the worker was making in     */
+/*  <file>, starts a new worker in its place and hands it the rest of   */
+/*  the old one's tasks.  The system is left out of the output, and     */
+/*  the batch carries on.  With '-x#' a worker that spends more than #  */
+/*  seconds on one system is killed and treated the same way.           */
+/*                                                                      */
+/*  Each line of the quarantine file gives the place of the system in   */
+/*  the batch, its seed (or "snapshot" for one from a catalog) and what */
+/*  became of it:                                                       */
+/*                                                                      */
+/*      127 127 exit 1                                                  */
+/*      3518 3518 hung for 30 seconds                                   */
+/*                                                                      */
+/*  Nothing changes while the workers are well, so a supervised batch   */
+/*  runs as fast as any other.  The census, ranking or sample a worker  */
+/*  has built up dies with it, so these can't be supervised.            */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <time.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <errno.h>
+#include    <signal.h>
+#include    <unistd.h>
+#include    <sys/wait.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+#ifdef MULTIPROC
+
+extern int flag_workers;
+extern char *flag_quarantine;
+extern long flag_hang_limit;
+
+/*
+ *  The quarantine file, and how many systems have gone into it:
+ */
+FILE *quarantine = NULL;
+long quarantined_systems = 0;
+
+/*--------------------------------------------------------------------------*/
+/*   Write a task down a worker's task pipe, unless the worker has died.    */
+/*--------------------------------------------------------------------------*/
+void pass_task(int task_fd, char *task)
+{
+    long length, done;
+
+    length = (long)strlen(task);
+    while (length > 0) {
+        if ((done = write(task_fd, task, (size_t)length)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        task += done;
+        length -= done;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Hand a task to a worker.  When supervising, a copy is kept until the   */
+/*   worker sends back the system, and a worker that has died is left to    */
+/*   be found out when its results run dry.                                 */
+/*--------------------------------------------------------------------------*/
+void send_task(worker_info *worker, char *task)
+{
+    int last;
+
+    if (flag_quarantine == NULL) {
+        write_full(worker->task_fd, task, (long)strlen(task));
+        worker->in_flight++;
+        return;
+    }
+    last = (worker->first_queued + worker->in_flight) % WORKER_QUEUE_DEPTH;
+    if ((worker->queued[last] = (char *)malloc(strlen(task) + 1)) == NULL) {
+        perror("malloc'ing a task");
+        exit(1);
+    }
+    strcpy(worker->queued[last], task);
+    if (worker->in_flight++ == 0)
+        worker->busy_since = (long)time(NULL);
+    pass_task(worker->task_fd, task);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note that a worker has sent back (or died making) its oldest system.   */
+/*--------------------------------------------------------------------------*/
+void task_done(worker_info *worker)
+{
+    worker->in_flight--;
+    if (flag_quarantine == NULL)
+        return;
+    free(worker->queued[worker->first_queued]);
+    worker->queued[worker->first_queued] = NULL;
+    worker->first_queued = (worker->first_queued + 1) % WORKER_QUEUE_DEPTH;
+    worker->busy_since = (long)time(NULL);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Note in the quarantine file the system a worker died making, and make  */
+/*   up an empty record to take its place in the batch.                     */
+/*--------------------------------------------------------------------------*/
+char *quarantine_task(worker_info *worker, record_header *header, int status)
+{
+    char seed[TASK_LINE_SIZE];
+    char reason[TASK_LINE_SIZE];
+    char *text;
+
+    if ((quarantine == NULL) && ((quarantine = fopen(flag_quarantine, "a")) == NULL)) {
+        perror(flag_quarantine);
+        exit(1);
+    }
+    memset(header, 0, sizeof(record_header));
+    header->rejected = REJECTED_NONE;
+    if (sscanf(worker->queued[worker->first_queued], "%ld %31s", &header->index, seed) != 2)
+        strcpy(seed, "?");
+    if (worker->hung)
+        sprintf(reason, "hung for %ld seconds", flag_hang_limit);
+    else if (WIFSIGNALED(status))
+        sprintf(reason, "signal %d", WTERMSIG(status));
+    else sprintf(reason, "exit %d", WEXITSTATUS(status));
+    fprintf(quarantine, "%ld %s %s\n", header->index, seed, reason);
+    fflush(quarantine);
+    fprintf(stderr, "System %ld (seed %s) quarantined: %s\n", header->index, seed, reason);
+    quarantined_systems++;
+    if ((text = (char *)malloc(1)) == NULL) {
+        perror("malloc'ing a system record");
+        exit(1);
+    }
+    text[0] = '\0';
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Read the next finished system from worker 'which', as 'read_record'    */
+/*   does.  When supervising, a worker that has died is replaced by a new   */
+/*   one, which is handed the rest of its tasks, and an empty record is     */
+/*   returned for the system it died making.  'open_tasks' is FALSE once    */
+/*   there are no more tasks to hand out.                                   */
+/*--------------------------------------------------------------------------*/
+char *next_record(worker_info *workers, int which, record_header *header, int open_tasks)
+{
+    worker_info *worker = &workers[which];
+    char *text;
+    int status, k;
+
+    if (flag_quarantine == NULL) {
+        text = read_record(worker, header);
+        task_done(worker);
+        return(text);
+    }
+    if ((text = fetch_record(worker, header)) != NULL) {
+        task_done(worker);
+        return(text);
+    }
+    if (worker->task_fd >= 0)
+        close(worker->task_fd);
+    close(worker->result_fd);
+    kill((pid_t)worker->pid, SIGKILL);
+    status = 0;
+    waitpid((pid_t)worker->pid, &status, 0);
+    text = quarantine_task(worker, header, status);
+    task_done(worker);
+    worker->hung = FALSE;
+    start_worker(workers, which, flag_workers);
+    for (k = 0; k < worker->in_flight; k++)
+        pass_task(worker->task_fd, worker->queued[(worker->first_queued + k)
+                                                  % WORKER_QUEUE_DEPTH]);
+    if (!open_tasks) {
+        close(worker->task_fd);
+        worker->task_fd = -1;
+    }
+    return(text);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   How long to wait for the workers before checking for hung ones, in     */
+/*   milliseconds, or -1 to wait for as long as they take.                  */
+/*--------------------------------------------------------------------------*/
+int hang_timeout(worker_info *workers, int count)
+{
+    long now, left, soonest;
+    int i;
+
+    if (flag_hang_limit == 0)
+        return(-1);
+    now = (long)time(NULL);
+    soonest = flag_hang_limit;
+    for (i = 0; i < count; i++) {
+        if (workers[i].in_flight == 0)
+            continue;
+        left = workers[i].busy_since + flag_hang_limit - now;
+        if (left < soonest)
+            soonest = left;
+    }
+    if (soonest < 0)
+        soonest = 0;
+    return((int)(soonest * 1000L + 1000L));
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Kill any worker that has spent too long on one system.  It is then     */
+/*   replaced just as if it had died by itself.                             */
+/*--------------------------------------------------------------------------*/
+void kill_hung_workers(worker_info *workers, int count)
+{
+    long now;
+    int i;
+
+    if (flag_hang_limit == 0)
+        return;
+    now = (long)time(NULL);
+    for (i = 0; i < count; i++) {
+        if ((workers[i].in_flight > 0) && !workers[i].hung
+            && (now - workers[i].busy_since >= flag_hang_limit)) {
+            workers[i].hung = TRUE;
+            kill((pid_t)workers[i].pid, SIGKILL);
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Say how many systems were quarantined.                                 */
+/*--------------------------------------------------------------------------*/
+void report_quarantine(void)
+{
+    if (quarantine == NULL)
+        return;
+    fclose(quarantine);
+    quarantine = NULL;
+    fprintf(stderr, "%ld systems quarantined in %s\n", quarantined_systems, flag_quarantine);
+}
+
+#endif /* MULTIPROC */
@@ -0,0 +1,248 @@
+/*----------------------------------------------------------------------*/
+/*                               timing.c                               */
+/*                                                                      */
+/*  Finding out where the time goes in a batch (the -i flag).  Each     */
+/*  system's time is split between the stages of making it: its stars,  */
+/*  setting up the planet list, accretion, checking the planets against */
+/*  the stars, building moons, working out the planets' environments,   */
+/*  and describing the system.  After each system the time it spent in  */
+/*  each stage, and in all, goes into a histogram for that stage.  The  */
+/*  histograms have sixteen bins to each doubling of time, so any       */
+/*  quantile read from them is within about 6% of the true one, and     */
+/*  they can be merged just by adding up their bins: each worker keeps  */
+/*  its own and sends them back at the end of the batch, just as it     */
+/*  does its census.  The median, 90th and 99th percentiles and the     */
+/*  longest time of each stage are then reported, along with the CPU    */
+/*  time used by the whole run, on the standard error or as JSON.       */
+/*                                                                      */
+/*  Without -i the clock is never read, so a batch runs just as fast    */
+/*  as before.                                                          */
+/*----------------------------------------------------------------------*/
+/* (c) Copyright Matt Burdick 1991 - All Rights Reserved                */
+/*----------------------------------------------------------------------*/
+#include	<stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <math.h>
+
+#include	"config.h"
+
+#ifdef MULTIPROC
+#include    <time.h>
+#include    <sys/time.h>
+#include    <sys/resource.h>
+#endif
+
+#include	"const.h"
+#include	"structs.h"
+#include	"protos.h"
+
+extern char *flag_timing;
+
+/*
+ *  The names of the stages, their histograms, and the time each has
+ *  taken so far in the system being made:
+ */
+char *stage_names[TIMING_STAGES] = {
+	"stars", "planet_list", "accretion", "check_planets",
+	"moons", "environment", "display", "system"
+};
+timing_histogram stage_histograms[TIMING_STAGES];
+double stage_seconds[TIMING_STAGES];
+int stage_used[TIMING_STAGES];
+double system_started;
+
+/*--------------------------------------------------------------------------*/
+/*   The time now, in seconds, if stages are being timed (or 0 if not).     */
+/*--------------------------------------------------------------------------*/
+double stage_clock(void)
+{
+#ifdef MULTIPROC
+    struct timespec now;
+
+    if (flag_timing == NULL)
+        return(0.0);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return((double)now.tv_sec + now.tv_nsec / 1.0E9);
+#else
+    if (flag_timing == NULL)
+        return(0.0);
+    return(wall_clock());
+#endif
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add the time since 'started' to a stage of the system being made.      */
+/*--------------------------------------------------------------------------*/
+void stage_done(int stage, double started)
+{
+    if (flag_timing == NULL)
+        return;
+    stage_seconds[stage] += stage_clock() - started;
+    stage_used[stage] = TRUE;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add a time to a histogram.  Times below a nanosecond go in the first   */
+/*   bin, and those above the last in the last.                             */
+/*--------------------------------------------------------------------------*/
+void add_time(timing_histogram *histogram, double seconds)
+{
+    double fraction;
+    int exponent;
+    long bin;
+
+    histogram->count++;
+    histogram->total += seconds;
+    if (seconds > histogram->max)
+        histogram->max = seconds;
+    bin = 0;
+    if (seconds * 1.0E9 >= 1.0) {
+        fraction = frexp(seconds * 1.0E9, &exponent);
+        bin = (long)(exponent - 1) * TIMING_SUB_BINS
+              + (long)((2.0 * fraction - 1.0) * TIMING_SUB_BINS);
+        if (bin >= TIMING_BINS)
+            bin = TIMING_BINS - 1;
+    }
+    histogram->bins[bin]++;
+}
+
+/*--------------------------------------------------------------------------*/
+/*   The time by which fraction 'q' of the times in a histogram had passed: */
+/*   the top of the bin it falls in, or the longest time if that is less.   */
+/*--------------------------------------------------------------------------*/
+double time_quantile(timing_histogram *histogram, double q)
+{
+    double wanted, seen, top;
+    long bin;
+
+    if (histogram->count == 0)
+        return(0.0);
+    wanted = ceil(q * histogram->count);
+    seen = 0.0;
+    for (bin = 0; bin < TIMING_BINS - 1; bin++) {
+        seen += histogram->bins[bin];
+        if (seen >= wanted)
+            break;
+    }
+    top = ldexp(1.0 + (double)(bin % TIMING_SUB_BINS + 1) / TIMING_SUB_BINS,
+                (int)(bin / TIMING_SUB_BINS)) / 1.0E9;
+    return((top < histogram->max) ? top : histogram->max);
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Start timing a new system.                                             */
+/*--------------------------------------------------------------------------*/
+void start_system_timing(void)
+{
+    if (flag_timing == NULL)
+        return;
+    memset(stage_seconds, 0, sizeof(stage_seconds));
+    memset(stage_used, 0, sizeof(stage_used));
+    system_started = stage_clock();
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Add the time each stage of the system just made took, and the time it  */
+/*   took in all, to their histograms.                                      */
+/*--------------------------------------------------------------------------*/
+void end_system_timing(void)
+{
+    int i;
+
+    if (flag_timing == NULL)
+        return;
+    stage_done(TIMING_SYSTEM, system_started);
+    for (i = 0; i < TIMING_STAGES; i++) {
+        if (stage_used[i])
+            add_time(&stage_histograms[i], stage_seconds[i]);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Merge histograms sent back by a worker process into these.             */
+/*--------------------------------------------------------------------------*/
+void merge_timing(timing_histogram *histograms)
+{
+    long bin;
+    int i;
+
+    for (i = 0; i < TIMING_STAGES; i++) {
+        stage_histograms[i].count += histograms[i].count;
+        stage_histograms[i].total += histograms[i].total;
+        if (histograms[i].max > stage_histograms[i].max)
+            stage_histograms[i].max = histograms[i].max;
+        for (bin = 0; bin < TIMING_BINS; bin++)
+            stage_histograms[i].bins[bin] += histograms[i].bins[bin];
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/*   Report the time each stage took, in microseconds, and the CPU time the */
+/*   run used: on the standard error, and as JSON in the file given with    */
+/*   -i if there is one.                                                    */
+/*--------------------------------------------------------------------------*/
+void report_timing(void)
+{
+    timing_histogram *histogram;
+    double user, system;
+    long largest;
+    FILE *fp;
+    int i;
+#ifdef MULTIPROC
+    struct rusage self, children;
+#endif
+
+    if (flag_timing == NULL)
+        return;
+    user = system = 0.0;
+    largest = 0;
+#ifdef MULTIPROC
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    user = self.ru_utime.tv_sec + self.ru_utime.tv_usec / 1.0E6
+           + children.ru_utime.tv_sec + children.ru_utime.tv_usec / 1.0E6;
+    system = self.ru_stime.tv_sec + self.ru_stime.tv_usec / 1.0E6
+             + children.ru_stime.tv_sec + children.ru_stime.tv_usec / 1.0E6;
+    largest = (self.ru_maxrss > children.ru_maxrss) ? self.ru_maxrss : children.ru_maxrss;
+#endif
+    fprintf(stderr, "Time per system (microseconds):\n");
+    fprintf(stderr, "    stage            systems        p50        p90        p99"
+                    "        max       mean\n");
+    for (i = 0; i < TIMING_STAGES; i++) {
+        histogram = &stage_histograms[i];
+        if (histogram->count == 0)
+            continue;
+        fprintf(stderr, "    %-13s %10ld %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                stage_names[i], histogram->count,
+                time_quantile(histogram, 0.50) * 1.0E6,
+                time_quantile(histogram, 0.90) * 1.0E6,
+                time_quantile(histogram, 0.99) * 1.0E6,
+                histogram->max * 1.0E6, histogram->total / histogram->count * 1.0E6);
+    }
+    fprintf(stderr, "CPU time %.2f sec user, %.2f sec system; largest process %ld K\n",
+            user, system, largest);
+    if (*flag_timing == '\0')
+        return;
+    if ((fp = fopen(flag_timing, "w")) == NULL) {
+        perror(flag_timing);
+        exit(1);
+    }
+    fprintf(fp, "{\"stages\": {");
+    for (i = 0; i < TIMING_STAGES; i++) {
+        histogram = &stage_histograms[i];
+        fprintf(fp, "%s\n  \"%s\": {\"count\": %ld", (i > 0) ? "," : "",
+                stage_names[i], histogram->count);
+        if (histogram->count > 0)
+            fprintf(fp, ", \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, "
+                        "\"max_us\": %.3f, \"mean_us\": %.3f",
+                    time_quantile(histogram, 0.50) * 1.0E6,
+                    time_quantile(histogram, 0.90) * 1.0E6,
+                    time_quantile(histogram, 0.99) * 1.0E6,
+                    histogram->max * 1.0E6, histogram->total / histogram->count * 1.0E6);
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "},\n \"cpu\": {\"user_sec\": %.3f, \"system_sec\": %.3f, "
+                "\"max_rss_kb\": %ld}}\n", user, system, largest);
+    fclose(fp);
+}
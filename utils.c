@@ -14,12 +14,32 @@
 #include    <errno.h>
 #include	<stdio.h>
 #include    <stdlib.h>
+#include    <sys/types.h>
+#include    <sys/timeb.h>
 
 #include    "config.h"
+
+#ifdef MULTIPROC
+#include    <sys/time.h>
+#endif
 #include    "const.h"
 #include    "structs.h"
 #include    "protos.h"
 
+extern physics_params physics;
+
+/*
+ *  The random numbers come from a generator of our own rather than
+ *  rand(), so that each system can have several independent streams
+ *  of them: one for its stars, one for its accretion, and one each for
+ *  the environment and the moons of every planet.  Each stream is
+ *  worked out afresh from the system's seed, so turning on one part
+ *  of the model (moons, say) never changes the numbers the others get.
+ *  Only 32 bits of each 'unsigned long' are used.
+ */
+unsigned long random_system_seed = 1;
+unsigned long random_state = 1;
+
 double power(double x, double y)
 {
     double result;
@@ -51,7 +71,76 @@ double random_number(double bound1, double bound2)
     else {
         return(bound1);    /* Since bound1 must equal bound2 */
     }
-    return((((double)rand()) / (double)(RAND_MAX)) * range + lowbound);
+    return(((double)next_random() / 4294967295.0) * range + lowbound);
+}
+
+/*----------------------------------------------------------------------*/
+/*  Step the current stream on (a 32-bit xorshift generator) and        */
+/*  return its next value, which is never 0.                            */
+/*----------------------------------------------------------------------*/
+
+unsigned long next_random(void)
+{
+    random_state ^= (random_state << 13) & 0xFFFFFFFFUL;
+    random_state ^= random_state >> 17;
+    random_state ^= (random_state << 5) & 0xFFFFFFFFUL;
+    return(random_state);
+}
+
+/*----------------------------------------------------------------------*/
+/*  Scramble the bits of a 32-bit value, so that nearby values give     */
+/*  unrelated results.                                                  */
+/*----------------------------------------------------------------------*/
+
+unsigned long mix_bits(unsigned long x)
+{
+    x &= 0xFFFFFFFFUL;
+    x ^= x >> 16;
+    x = (x * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+    x ^= x >> 15;
+    x = (x * 0x846CA68BUL) & 0xFFFFFFFFUL;
+    x ^= x >> 16;
+    return(x);
+}
+
+/*----------------------------------------------------------------------*/
+/*  Seed the random-number generator for a system, and start drawing    */
+/*  from its stream for the stars.                                      */
+/*----------------------------------------------------------------------*/
+
+void seed_random(unsigned seed)
+{
+    random_system_seed = (unsigned long)seed & 0xFFFFFFFFUL;
+    use_stream(STREAM_STARS, 0L);
+}
+
+/*----------------------------------------------------------------------*/
+/*  Switch to stream 'stream' (STREAM_STARS, ...) of the current        */
+/*  system.  'number' picks out one of a family of streams, such as     */
+/*  the one for a given planet.  A stream always starts at the same     */
+/*  place, however much the other streams have been used.               */
+/*----------------------------------------------------------------------*/
+
+void use_stream(int stream, long number)
+{
+    random_state = stream_start(stream, number);
+}
+
+/*----------------------------------------------------------------------*/
+/*  Work out where stream 'stream', number 'number', of the current     */
+/*  system starts, without switching to it.                             */
+/*----------------------------------------------------------------------*/
+
+unsigned long stream_start(int stream, long number)
+{
+    unsigned long state;
+
+    state = mix_bits(mix_bits(random_system_seed)
+                     ^ ((unsigned long)stream * 0x9E3779B9UL));
+    state = mix_bits(state + (unsigned long)number);
+    if (state == 0)
+        state = 1;
+    return(state);
 }
 
 /*----------------------------------------------------------------------*/
@@ -66,7 +155,25 @@ double about(double value, double variation)
 
 double random_eccentricity(void)
 {
-    return(1.0 - power(random_number(0.0001, 1.0),ECCENTRICITY_COEFF));
+    return(1.0 - power(random_number(0.0001, 1.0),physics.eccentricity_coeff));
 }
 
+/*----------------------------------------------------------------------*/
+/*  The time of day, in seconds.  Where it's available, the clock is    */
+/*  read to the microsecond rather than the millisecond.                */
+/*----------------------------------------------------------------------*/
+
+double wall_clock(void)
+{
+#ifdef MULTIPROC
+    struct timeval now;
 
+    gettimeofday(&now, NULL);
+    return((double)now.tv_sec + now.tv_usec / 1.0E6);
+#else
+    struct timeb grap;
+
+    ftime(&grap);
+    return((double)grap.time + grap.millitm / 1000.0);
+#endif
+}